@@ -0,0 +1,42 @@
+#include "arguments.hpp"
+
+#include <cstdint>
+
+std::optional<size_t> parse_size(std::string_view value) {
+    if (value.empty() || value.size() > 18) {
+        return std::nullopt;
+    }
+    size_t result = 0;
+    for (char chr: value) {
+        if (chr < '0' || chr > '9') {
+            return std::nullopt;
+        }
+        result = result * 10 + static_cast<size_t>(chr - '0');
+    }
+    return result;
+}
+
+std::optional<size_t> parse_byte_size(std::string_view value) {
+    size_t shift = 0;
+    if (!value.empty()) {
+        switch (value.back()) {
+        case 'K':
+            shift = 10;
+            break;
+        case 'M':
+            shift = 20;
+            break;
+        case 'G':
+            shift = 30;
+            break;
+        }
+    }
+    if (shift != 0) {
+        value.remove_suffix(1);
+    }
+    std::optional<size_t> result = parse_size(value);
+    if (!result.has_value() || *result > (SIZE_MAX >> shift)) {
+        return std::nullopt;
+    }
+    return *result << shift;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+// Разбор числовых аргументов командной строки. Ошибка -- nullopt,
+//   программа печатает usage.
+
+// Неотрицательное целое число: только цифры, без знаков и пробелов.
+std::optional<size_t> parse_size(std::string_view value);
+
+// Размер в байтах, с необязательным двоичным суффиксом K, M или G.
+std::optional<size_t> parse_byte_size(std::string_view value);
@@ -0,0 +1,372 @@
+// Замеры производительности: построение суффиксного массива
+//   (SA-IS и удвоением, в одном потоке и на всех ядрах), lcp и
+//   наидлиннейшей общей подстроки на данных разного вида и
+//   размера, а также прогон программы целиком на директориях
+//   (их готовит gen_corpus) с пиковой памятью процесса.
+//
+// bench [--max-size BYTES] [--filter NAME] [--min-time SECONDS]
+// bench --e2e PROGRAM DIR1 DIR2 [ARGS...]
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "arguments.hpp"
+#include "corpus.hpp"
+#include "parallel.hpp"
+#include "substr_check.hpp"
+#include "suffix_array.hpp"
+#include "workspace.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t kMiB = 1024 * 1024;
+
+    // Вид данных. Для пар вторая строка получается из первой
+    //   мутациями, как похожий файл из исходного.
+    struct Shape {
+        std::string_view name;
+        std::function<std::vector<uint8_t>(size_t, std::mt19937_64&)> make;
+    };
+
+    std::vector<uint8_t> make_random(size_t size, std::mt19937_64& rng) {
+        std::vector<uint8_t> data(size);
+        for (uint8_t& chr: data) {
+            chr = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    // Четыре символа с неравными частотами, как в текстах и
+    //   геномах: много коротких повторов, lcp небольшие.
+    std::vector<uint8_t> make_low_entropy(size_t size, std::mt19937_64& rng) {
+        std::discrete_distribution<int> letter({50, 25, 15, 10});
+        std::vector<uint8_t> data(size);
+        for (uint8_t& chr: data) {
+            chr = static_cast<uint8_t>("acgt"[letter(rng)]);
+        }
+        return data;
+    }
+
+    // Блок в 4 Кб, повторённый с редкими заменами: lcp длинные,
+    //   как в сборках бинарников с общими частями.
+    std::vector<uint8_t> make_repetitive(size_t size, std::mt19937_64& rng) {
+        std::vector<uint8_t> block = make_random(std::min<size_t>(size, 4096), rng);
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = block[i % block.size()];
+        }
+        for (size_t i = 0; i < size / 10000; ++i) {
+            data[rng() % size] = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    // Случайные записи до 1 Кб, разделённые нулями длиной до
+    //   64 Кб, как в образах дисков и форматах с выравниванием.
+    //   Длинные серии одного байта -- худший случай для проверки
+    //   общей подстроки: одна k-грамма встречается много раз.
+    std::vector<uint8_t> make_zero_padded(size_t size, std::mt19937_64& rng) {
+        std::vector<uint8_t> data;
+        data.reserve(size);
+        while (data.size() < size) {
+            const size_t record_size = std::min<size_t>(size - data.size(), 1 + rng() % 1024);
+            for (size_t i = 0; i < record_size; ++i) {
+                data.push_back(static_cast<uint8_t>(rng()));
+            }
+            const size_t padding_size = std::min<size_t>(size - data.size(), rng() % 65536);
+            data.insert(data.end(), padding_size, 0);
+        }
+        return data;
+    }
+
+    // Копия с заменами, вставками и удалениями примерно
+    //   на каждые rate байт.
+    std::vector<uint8_t> mutate(std::span<const uint8_t> data, size_t rate, std::mt19937_64& rng) {
+        std::vector<uint8_t> result;
+        result.reserve(data.size() + data.size() / rate + 1);
+        for (uint8_t chr: data) {
+            if (rng() % rate != 0) {
+                result.push_back(chr);
+                continue;
+            }
+            switch (rng() % 3) {
+            case 0:
+                result.push_back(static_cast<uint8_t>(rng()));
+                break;
+            case 1:
+                result.push_back(chr);
+                result.push_back(static_cast<uint8_t>(rng()));
+                break;
+            default:
+                break;
+            }
+        }
+        return result;
+    }
+
+    // Пиковая память процесса с последнего сброса. Сброс через
+    //   /proc/self/clear_refs есть в Linux с 4.0; без него
+    //   получится пик за всё время работы.
+    void reset_peak_rss() {
+        std::ofstream stream("/proc/self/clear_refs");
+        stream << "5";
+    }
+
+    size_t peak_rss_bytes() {
+        std::ifstream stream("/proc/self/status");
+        std::string line;
+        while (std::getline(stream, line)) {
+            if (line.starts_with("VmHWM:")) {
+                return static_cast<size_t>(std::stoull(line.substr(6))) * 1024;
+            }
+        }
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+    }
+
+    struct Measurement {
+        double seconds = 0;
+        size_t peak_rss = 0;
+    };
+
+    // Лучшее время из повторов: повторяем, пока не наберётся
+    //   min_time, но хотя бы раз.
+    Measurement measure(const std::function<void()>& body, double min_time) {
+        Measurement result;
+        result.seconds = std::numeric_limits<double>::infinity();
+        reset_peak_rss();
+        double total = 0;
+        do {
+            Clock::time_point start = Clock::now();
+            body();
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            result.seconds = std::min(result.seconds, seconds);
+            total += seconds;
+        } while (total < min_time);
+        result.peak_rss = peak_rss_bytes();
+        return result;
+    }
+
+    void report(std::string_view name, std::string_view shape, size_t size, const Measurement& measurement) {
+        const double mib = static_cast<double>(size) / kMiB;
+        std::cout << std::left << std::setw(26) << name << std::setw(14) << shape
+                  << std::right << std::setw(6) << std::fixed << std::setprecision(1) << mib << " MiB"
+                  << std::setw(10) << std::setprecision(3) << measurement.seconds << " s"
+                  << std::setw(10) << std::setprecision(2) << mib / measurement.seconds << " MiB/s"
+                  << std::setw(10) << std::setprecision(1) << static_cast<double>(measurement.peak_rss) / kMiB << " MiB peak\n";
+    }
+
+    int run_kernels(size_t max_size, std::string_view filter, double min_time) {
+        const Shape shapes[] = {
+            {"random", make_random},
+            {"low-entropy", make_low_entropy},
+            {"repetitive", make_repetitive},
+            {"zero-padded", make_zero_padded},
+        };
+        const size_t sizes[] = {kMiB, 4 * kMiB, 10 * kMiB, 20 * kMiB};
+
+        auto enabled = [&](std::string_view name) {
+            return filter.empty() || name.find(filter) != std::string_view::npos;
+        };
+
+        for (const Shape& shape: shapes) {
+            for (size_t size: sizes) {
+                if (size > max_size) {
+                    continue;
+                }
+                std::mt19937_64 rng(size);
+                std::vector<uint8_t> text = shape.make(size, rng);
+
+                // Тексты короче 4 Гб, позиции 32-битные.
+                std::vector<uint32_t> suffix_array;
+                std::vector<uint32_t> inv_suffix_array;
+                Workspace workspace;
+                if (enabled("suffix_array")) {
+                    report("suffix_array", shape.name, size, measure([&] {
+                        get_suffix_array(text, suffix_array, inv_suffix_array, workspace);
+                    }, min_time));
+                    // На всех ядрах.
+                    report("suffix_array_parallel", shape.name, size, measure([&] {
+                        get_suffix_array(text, suffix_array, inv_suffix_array, workspace, default_num_threads());
+                    }, min_time));
+                }
+                if (enabled("prefix_doubling")) {
+                    report("prefix_doubling", shape.name, size, measure([&] {
+                        get_suffix_array_prefix_doubling(text, suffix_array, inv_suffix_array, workspace);
+                    }, min_time));
+                }
+                if (enabled("lcp")) {
+                    if (suffix_array.size() != text.size()) {
+                        get_suffix_array(text, suffix_array, inv_suffix_array, workspace);
+                    }
+                    std::vector<uint32_t> lcp;
+                    std::vector<uint32_t> plcp;
+                    report("lcp", shape.name, size, measure([&] {
+                        calculate_lcp(text, suffix_array, lcp, plcp);
+                    }, min_time));
+                }
+                suffix_array = std::vector<uint32_t>();
+                inv_suffix_array = std::vector<uint32_t>();
+
+                // Пары: половина размера на строку, чтобы склеенная
+                //   строка была того же размера, что и выше.
+                if (enabled("lcs")) {
+                    std::vector<uint8_t> first(text.begin(), text.begin() + size / 2);
+                    std::vector<uint8_t> copy = mutate(first, 1000, rng);
+                    std::vector<uint8_t> other = shape.make(size / 2, rng);
+                    report("lcs mutated", shape.name, first.size() + copy.size(), measure([&] {
+                        get_longest_cmn_substr_len(first, copy, workspace);
+                    }, min_time));
+                    report("lcs unrelated", shape.name, first.size() + other.size(), measure([&] {
+                        get_longest_cmn_substr_len(first, other, workspace);
+                    }, min_time));
+                }
+                // Проверка на длину на единицу больше наидлиннейшей
+                //   общей подстроки: ответ "нет", проходится вся пара.
+                if (enabled("substr_check")) {
+                    std::vector<uint8_t> first(text.begin(), text.begin() + size / 2);
+                    std::vector<uint8_t> copy = mutate(first, 1000, rng);
+                    std::vector<uint8_t> other = shape.make(size / 2, rng);
+                    const size_t copy_len = get_longest_cmn_substr_len(first, copy, workspace) + 1;
+                    const size_t other_len = get_longest_cmn_substr_len(first, other, workspace) + 1;
+                    report("substr_check mutated", shape.name, first.size() + copy.size(), measure([&] {
+                        has_cmn_substr_of_len(first, copy, copy_len);
+                    }, min_time));
+                    report("substr_check unrelated", shape.name, first.size() + other.size(), measure([&] {
+                        has_cmn_substr_of_len(first, other, other_len);
+                    }, min_time));
+                }
+            }
+        }
+        return 0;
+    }
+
+    size_t directory_size(const fs::path& dir) {
+        size_t total = 0;
+        for (const auto& item: fs::directory_iterator(dir)) {
+            std::error_code error;
+            uintmax_t size = fs::file_size(item.path(), error);
+            if (!error) {
+                total += static_cast<size_t>(size);
+            }
+        }
+        return total;
+    }
+
+    // Запускает программу сравнения и печатает время, скорость по
+    //   объёму входных файлов и пиковую память дочернего процесса.
+    //   Вывод программы отбрасывается.
+    //   argv -- программа и её аргументы, первые два -- директории.
+    int run_end_to_end(int argc, char** argv) {
+        const size_t input_size = directory_size(argv[1]) + directory_size(argv[2]);
+
+        Clock::time_point start = Clock::now();
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            std::freopen("/dev/null", "w", stdout);
+            std::vector<char*> args(argv, argv + argc);
+            args.push_back(nullptr);
+            execv(args[0], args.data());
+            std::perror("execv");
+            _exit(127);
+        }
+        int status = 0;
+        rusage usage{};
+        wait4(pid, &status, 0, &usage);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        double cpu_seconds = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+
+        const double mib = static_cast<double>(input_size) / kMiB;
+        std::cout << std::fixed << std::setprecision(3)
+                  << "input      " << std::setprecision(1) << mib << " MiB\n"
+                  << "wall       " << std::setprecision(3) << seconds << " s\n"
+                  << "cpu        " << cpu_seconds << " s\n"
+                  << "throughput " << std::setprecision(2) << mib / seconds << " MiB/s\n"
+                  << "peak rss   " << std::setprecision(1) << static_cast<double>(usage.ru_maxrss) / 1024 << " MiB\n"
+                  << "exit code  " << (WIFEXITED(status) ? WEXITSTATUS(status) : -1) << '\n';
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    }
+
+    // Разбирает неотрицательное конечное число секунд, строка должна
+    //   быть числом целиком.
+    std::optional<double> parse_seconds(std::string_view value) {
+        double result = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (value.empty() || error != std::errc() || end != value.data() + value.size() || !std::isfinite(result) || result < 0) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    void print_usage(std::string_view program_path) {
+        std::cout << "Usage: " << program_path << " [--max-size BYTES] [--filter NAME] [--min-time SECONDS]\n"
+                  << "       " << program_path << " --e2e PROGRAM DIR1 DIR2 [ARGS...]\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string_view(argv[1]) == "--e2e") {
+        if (argc < 5) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return run_end_to_end(argc - 2, argv + 2);
+    }
+
+    size_t max_size = 20 * kMiB;
+    std::string_view filter;
+    double min_time = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+        if (i + 1 == argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (arg == "--max-size") {
+            std::optional<size_t> value = parse_size(argv[++i]);
+            if (!value.has_value()) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            max_size = *value;
+        } else if (arg == "--filter") {
+            filter = argv[++i];
+        } else if (arg == "--min-time") {
+            std::optional<double> value = parse_seconds(argv[++i]);
+            if (!value.has_value()) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            min_time = *value;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    return run_kernels(max_size, filter, min_time);
+}
@@ -0,0 +1,164 @@
+#include "byte_compare.hpp"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTE_COMPARE_X86 1
+#endif
+
+namespace {
+    using PrefixFn = size_t (*)(const uint8_t*, const uint8_t*, size_t);
+    using SuffixFn = size_t (*)(const uint8_t*, const uint8_t*, size_t);
+
+    uint64_t load_u64(const uint8_t* data) {
+        uint64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Словами по 8 байт. На little-endian первый отличающийся байт
+    //   даёт младший ненулевой бит xor, последний -- старший.
+    size_t common_prefix_len_scalar(const uint8_t* first, const uint8_t* second, size_t limit) {
+        size_t len = 0;
+        if constexpr (std::endian::native == std::endian::little) {
+            for (; len + 8 <= limit; len += 8) {
+                uint64_t diff = load_u64(first + len) ^ load_u64(second + len);
+                if (diff != 0) {
+                    return len + static_cast<size_t>(std::countr_zero(diff)) / 8;
+                }
+            }
+        }
+        while (len < limit && first[len] == second[len]) {
+            ++len;
+        }
+        return len;
+    }
+
+    size_t common_suffix_len_scalar(const uint8_t* first_end, const uint8_t* second_end, size_t limit) {
+        size_t len = 0;
+        if constexpr (std::endian::native == std::endian::little) {
+            for (; len + 8 <= limit; len += 8) {
+                uint64_t diff = load_u64(first_end - len - 8) ^ load_u64(second_end - len - 8);
+                if (diff != 0) {
+                    return len + static_cast<size_t>(std::countl_zero(diff)) / 8;
+                }
+            }
+        }
+        while (len < limit && first_end[-1 - static_cast<ptrdiff_t>(len)] == second_end[-1 - static_cast<ptrdiff_t>(len)]) {
+            ++len;
+        }
+        return len;
+    }
+
+#ifdef BYTE_COMPARE_X86
+    // Бит i маски -- байты i блоков равны. Первое отличие --
+    //   младший нулевой бит маски, последнее -- старший.
+    __attribute__((target("sse2")))
+    size_t common_prefix_len_sse2(const uint8_t* first, const uint8_t* second, size_t limit) {
+        size_t len = 0;
+        for (; len + 16 <= limit; len += 16) {
+            __m128i lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + len));
+            __m128i rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + len));
+            uint32_t equal = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs)));
+            if (equal != 0xFFFF) {
+                return len + static_cast<size_t>(std::countr_zero(~equal));
+            }
+        }
+        return len + common_prefix_len_scalar(first + len, second + len, limit - len);
+    }
+
+    __attribute__((target("sse2")))
+    size_t common_suffix_len_sse2(const uint8_t* first_end, const uint8_t* second_end, size_t limit) {
+        size_t len = 0;
+        for (; len + 16 <= limit; len += 16) {
+            __m128i lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first_end - len - 16));
+            __m128i rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second_end - len - 16));
+            uint32_t equal = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs)));
+            if (equal != 0xFFFF) {
+                return len + static_cast<size_t>(std::countl_zero(static_cast<uint16_t>(~equal)));
+            }
+        }
+        return len + common_suffix_len_scalar(first_end - len, second_end - len, limit - len);
+    }
+
+    __attribute__((target("avx2")))
+    size_t common_prefix_len_avx2(const uint8_t* first, const uint8_t* second, size_t limit) {
+        size_t len = 0;
+        for (; len + 32 <= limit; len += 32) {
+            __m256i lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + len));
+            __m256i rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + len));
+            uint32_t equal = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+            if (equal != 0xFFFFFFFF) {
+                return len + static_cast<size_t>(std::countr_zero(~equal));
+            }
+        }
+        return len + common_prefix_len_sse2(first + len, second + len, limit - len);
+    }
+
+    __attribute__((target("avx2")))
+    size_t common_suffix_len_avx2(const uint8_t* first_end, const uint8_t* second_end, size_t limit) {
+        size_t len = 0;
+        for (; len + 32 <= limit; len += 32) {
+            __m256i lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first_end - len - 32));
+            __m256i rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second_end - len - 32));
+            uint32_t equal = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+            if (equal != 0xFFFFFFFF) {
+                return len + static_cast<size_t>(std::countl_zero(~equal));
+            }
+        }
+        return len + common_suffix_len_sse2(first_end - len, second_end - len, limit - len);
+    }
+#endif
+
+    PrefixFn choose_prefix_impl() {
+#ifdef BYTE_COMPARE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return common_prefix_len_avx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return common_prefix_len_sse2;
+        }
+#endif
+        return common_prefix_len_scalar;
+    }
+
+    SuffixFn choose_suffix_impl() {
+#ifdef BYTE_COMPARE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return common_suffix_len_avx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return common_suffix_len_sse2;
+        }
+#endif
+        return common_suffix_len_scalar;
+    }
+
+    // Выбираются один раз при загрузке программы.
+    const PrefixFn prefix_impl = choose_prefix_impl();
+    const SuffixFn suffix_impl = choose_suffix_impl();
+}
+
+namespace detail {
+    size_t common_prefix_len_impl(const uint8_t* first, const uint8_t* second, size_t limit) {
+        return prefix_impl(first, second, limit);
+    }
+
+    size_t common_suffix_len_impl(const uint8_t* first_end, const uint8_t* second_end, size_t limit) {
+        return suffix_impl(first_end, second_end, limit);
+    }
+}
+
+bool bytes_equal(std::span<const uint8_t> first, std::span<const uint8_t> second) {
+    if (first.size() != second.size()) {
+        return false;
+    }
+    if (first.empty()) {
+        return true;
+    }
+    return prefix_impl(first.data(), second.data(), first.size()) == first.size();
+}
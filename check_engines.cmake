@@ -0,0 +1,28 @@
+# Сверяет отчёты main на DIR1 и DIR2 при разных движках и при
+#   маленьком --max-memory, когда пары считаются без индексов
+#   (bounded_cmn_substr_len). Отчёты должны совпадать байт в байт.
+#   --format text печатает процент каждой пары ниже порога, так
+#   сверяются и они.
+#
+# cmake -DMAIN=... -DDIR1=... -DDIR2=... -P check_engines.cmake
+
+foreach(format text sections)
+    foreach(percent 0 30 60 100)
+        set(reference_output "")
+        foreach(variant "--engine;sam" "--engine;sa" "--engine;sam;--max-memory;1K" "--engine;sa;--max-memory;1K")
+            execute_process(
+                COMMAND ${MAIN} ${DIR1} ${DIR2} ${percent} --format ${format} ${variant}
+                OUTPUT_VARIABLE output
+                RESULT_VARIABLE result)
+            if(NOT result EQUAL 0)
+                message(FATAL_ERROR "main ${percent} --format ${format} ${variant} exited with ${result}")
+            endif()
+            if(reference_output STREQUAL "")
+                set(reference_output "${output}")
+                set(reference_variant "${variant}")
+            elseif(NOT output STREQUAL reference_output)
+                message(FATAL_ERROR "Reports differ for percent ${percent}, --format ${format}: ${reference_variant} gives\n${reference_output}\n${variant} gives\n${output}")
+            endif()
+        endforeach()
+    endforeach()
+endforeach()
@@ -0,0 +1,108 @@
+#include "chunking.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include "content_hash.hpp"
+
+namespace {
+    // Случайные 64-битные числа на каждый байт, splitmix64 от номера.
+    constexpr std::array<uint64_t, 256> make_gear_table() {
+        std::array<uint64_t, 256> table{};
+        uint64_t state = 0;
+        for (uint64_t& value: table) {
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t mixed = state;
+            mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+            value = mixed ^ (mixed >> 31);
+        }
+        return table;
+    }
+
+    constexpr std::array<uint64_t, 256> kGear = make_gear_table();
+
+    // Хеш сдвигается влево, старшие биты зависят от последних
+    //   64 байт, младшие -- только от нескольких последних. Маски
+    //   берут старшие биты: log2(avg) + 2 до среднего размера
+    //   и log2(avg) - 2 после.
+    constexpr int kAvgBits = std::countr_zero(kChunkAvgSize);
+    constexpr uint64_t kMaskStrict = ~uint64_t(0) << (64 - (kAvgBits + 2));
+    constexpr uint64_t kMaskLoose = ~uint64_t(0) << (64 - (kAvgBits - 2));
+}
+
+size_t next_chunk_size(std::span<const uint8_t> data) {
+    if (data.size() <= kChunkMinSize) {
+        return data.size();
+    }
+    const size_t size = std::min(data.size(), kChunkMaxSize);
+    const size_t normal_size = std::min(size, kChunkAvgSize);
+    uint64_t hash = 0;
+    size_t pos = kChunkMinSize;
+    for (; pos < normal_size; ++pos) {
+        hash = (hash << 1) + kGear[data[pos]];
+        if ((hash & kMaskStrict) == 0) {
+            return pos + 1;
+        }
+    }
+    for (; pos < size; ++pos) {
+        hash = (hash << 1) + kGear[data[pos]];
+        if ((hash & kMaskLoose) == 0) {
+            return pos + 1;
+        }
+    }
+    return size;
+}
+
+ChunkSet compute_chunks(std::span<const uint8_t> data) {
+    ChunkSet chunks;
+    chunks.reserve(data.size() / kChunkAvgSize + 1);
+    for (size_t pos = 0; pos < data.size();) {
+        const size_t size = next_chunk_size(data.subspan(pos));
+        // 64 бита хеша содержимого: куски разного содержимого
+        //   с одинаковым хешем в пределах корпуса не встретятся.
+        chunks.push_back(ChunkEntry{hash_content(data.subspan(pos, size)).low, static_cast<uint32_t>(size), 1});
+        pos += size;
+    }
+
+    std::sort(chunks.begin(), chunks.end(), [](const ChunkEntry& lhs, const ChunkEntry& rhs) {
+        return lhs.hash < rhs.hash;
+    });
+    size_t num_distinct = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (num_distinct != 0 && chunks[num_distinct - 1].hash == chunks[i].hash) {
+            ++chunks[num_distinct - 1].count;
+        } else {
+            chunks[num_distinct++] = chunks[i];
+        }
+    }
+    chunks.resize(num_distinct);
+    return chunks;
+}
+
+void ChunkIndex::add(size_t file, const ChunkSet& chunks) {
+    for (const ChunkEntry& chunk: chunks) {
+        entries_.push_back(Entry{chunk.hash, file, chunk.count});
+    }
+}
+
+void ChunkIndex::build() {
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.hash < rhs.hash || (lhs.hash == rhs.hash && lhs.file < rhs.file);
+    });
+}
+
+void ChunkIndex::add_shared_sizes(const ChunkSet& chunks, std::vector<size_t>& shared_sizes) const {
+    // Хеши chunks возрастают, поэтому поиск продолжается с места
+    //   предыдущего, а не с начала индекса.
+    auto it = entries_.begin();
+    for (const ChunkEntry& chunk: chunks) {
+        it = std::lower_bound(it, entries_.end(), chunk.hash, [](const Entry& entry, uint64_t hash) {
+            return entry.hash < hash;
+        });
+        for (; it != entries_.end() && it->hash == chunk.hash; ++it) {
+            shared_sizes[it->file] += static_cast<size_t>(chunk.size) * std::min(chunk.count, it->count);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Разбиение файла на куски по содержимому (FastCDC: Ся и др.).
+//   Граница ставится там, где хеш Gear последних 64 байт
+//   попадает под маску, поэтому вставка или удаление в одном
+//   месте файла сдвигает только соседние границы, а остальные
+//   куски остаются прежними и находятся в другом файле по хешу.
+// Нормализация: до среднего размера маска строже, после --
+//   мягче, размеры кусков собираются около kChunkAvgSize.
+constexpr size_t kChunkMinSize = 512;
+constexpr size_t kChunkAvgSize = 2048;
+constexpr size_t kChunkMaxSize = 16384;
+
+// Различные куски файла: хеш, размер и сколько раз кусок
+//   встречается. Отсортированы по хешу.
+struct ChunkEntry {
+    uint64_t hash = 0;
+    uint32_t size = 0;
+    uint32_t count = 0;
+};
+
+using ChunkSet = std::vector<ChunkEntry>;
+
+// Длина первого куска data.
+size_t next_chunk_size(std::span<const uint8_t> data);
+
+ChunkSet compute_chunks(std::span<const uint8_t> data);
+
+// Обратный индекс: по хешу куска -- файлы, в которых он есть.
+//   Как и SketchIndex, один отсортированный массив.
+class ChunkIndex {
+public:
+    void add(size_t file, const ChunkSet& chunks);
+    // После добавления всех файлов и до запросов.
+    void build();
+
+    // Прибавляет к shared_sizes[file] (размера не меньше числа
+    //   файлов) число байт, общих у chunks с файлом file: по
+    //   каждому общему куску -- размер на меньшее из чисел
+    //   вхождений.
+    void add_shared_sizes(const ChunkSet& chunks, std::vector<size_t>& shared_sizes) const;
+
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        size_t file = 0;
+        uint32_t count = 0;
+    };
+
+    std::vector<Entry> entries_;
+};
@@ -0,0 +1,403 @@
+#include "comparison.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "byte_compare.hpp"
+#include "chunking.hpp"
+#include "content_hash.hpp"
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "substr_check.hpp"
+#include "suffix_array.hpp"
+#include "suffix_automaton.hpp"
+#include "workspace.hpp"
+
+namespace {
+    // Сколько свободных потоков нужно паре, чтобы строить её
+    //   суффиксный массив удвоением на потоках, а не SA-IS в одном.
+    //   Вся работа удвоения -- примерно 1.7 SA-IS на несвязанных
+    //   файлах и до 11 на похожих: проходов столько, сколько бит в
+    //   длине наидлиннейшего повтора, а до движка доходят как раз
+    //   похожие пары.
+    constexpr size_t kMinSuffixArrayThreads = 16;
+
+    // Побайтово одинаковые файлы находим по размеру и хешу
+    //   содержимого, без суффиксного массива. Для каждого файла
+    //   первой директории получаем список одинаковых с ним файлов
+    //   второй.
+    std::vector<std::vector<bool>> find_identical(const Corpus& corpus, std::span<const size_t> rows, std::span<const size_t> cols) {
+        Stats& stats = Stats::global();
+        std::unordered_map<ContentKey, std::vector<size_t>> cols_by_key;
+        for (size_t col = 0; col < cols.size(); ++col) {
+            cols_by_key[corpus.file(cols[col]).key()].push_back(col);
+        }
+
+        std::vector<std::vector<bool>> identical(rows.size());
+        for (size_t row = 0; row < rows.size(); ++row) {
+            identical[row].assign(cols.size(), false);
+            auto it = cols_by_key.find(corpus.file(rows[row]).key());
+            if (it == cols_by_key.end()) {
+                continue;
+            }
+            for (size_t col: it->second) {
+                // Если оба файла в памяти, проверяем побайтово: это
+                //   проход со скоростью чтения памяти, и совпадение
+                //   хешей не приходится принимать на веру. Хеши из кеша
+                //   принимаем: при 128 битах случайное совпадение
+                //   практически невозможно.
+                const size_t id1 = rows[row];
+                const size_t id2 = cols[col];
+                if (corpus.file(id1).loaded && corpus.file(id2).loaded && !bytes_equal(corpus.content(id1), corpus.content(id2))) {
+                    continue;
+                }
+                identical[row][col] = true;
+                stats.add(Counter::kPairsIdentical);
+            }
+        }
+        return identical;
+    }
+
+    // Классы побайтово одинаковых файлов среди ids, по размеру,
+    //   хешу и, если оба файла прочитаны, сравнению байтов.
+    struct ContentClasses {
+        // Первый файл каждого класса.
+        std::vector<size_t> representatives;
+        // Позиции в ids файлов каждого класса.
+        std::vector<std::vector<size_t>> members;
+    };
+
+    ContentClasses group_identical(const Corpus& corpus, std::span<const size_t> ids) {
+        ContentClasses classes;
+        std::unordered_map<ContentKey, std::vector<size_t>> classes_by_key;
+        for (size_t pos = 0; pos < ids.size(); ++pos) {
+            const size_t id = ids[pos];
+            std::vector<size_t>& same_key = classes_by_key[corpus.file(id).key()];
+            auto it = std::find_if(same_key.begin(), same_key.end(), [&](size_t cls) {
+                const size_t representative = classes.representatives[cls];
+                return !corpus.file(id).loaded || !corpus.file(representative).loaded ||
+                       bytes_equal(corpus.content(id), corpus.content(representative));
+            });
+            if (it != same_key.end()) {
+                classes.members[*it].push_back(pos);
+                continue;
+            }
+            same_key.push_back(classes.representatives.size());
+            classes.representatives.push_back(id);
+            classes.members.push_back({pos});
+        }
+        return classes;
+    }
+
+    // Копии одного содержимого внутри директории сравниваются
+    //   одинаково, потому сравниваем только представителей классов,
+    //   а результат пары классов раздаём всем парам их файлов.
+    template<typename CompareDistinct>
+    std::vector<PairMatch> compare_classes(const Corpus& corpus, std::span<const size_t> rows, std::span<const size_t> cols, CompareDistinct compare_distinct) {
+        Stats& stats = Stats::global();
+        stats.add(Counter::kPairs, rows.size() * cols.size());
+        const ContentClasses row_classes = group_identical(corpus, rows);
+        const ContentClasses col_classes = group_identical(corpus, cols);
+        stats.add(Counter::kPairsDeduplicated, rows.size() * cols.size() - row_classes.representatives.size() * col_classes.representatives.size());
+
+        std::vector<PairMatch> matches;
+        for (const PairMatch& class_match: compare_distinct(row_classes.representatives, col_classes.representatives)) {
+            for (size_t row: row_classes.members[class_match.row]) {
+                for (size_t col: col_classes.members[class_match.col]) {
+                    PairMatch match = class_match;
+                    match.row = row;
+                    match.col = col;
+                    matches.push_back(match);
+                }
+            }
+        }
+        std::sort(matches.begin(), matches.end(), [](const PairMatch& lhs, const PairMatch& rhs) {
+            return std::pair(lhs.row, lhs.col) < std::pair(rhs.row, rhs.col);
+        });
+        return matches;
+    }
+
+    std::vector<PairMatch> compare_distinct_files(Corpus& corpus, std::span<const Sketch> sketches, std::span<const size_t> rows, std::span<const size_t> cols, const ComparisonOptions& options) {
+        const int percent_for_not_eq = options.percent_for_not_eq;
+        std::vector<PairMatch> matches;
+        Stats& stats = Stats::global();
+        PhaseTimer candidates_timer(Phase::kCandidates);
+
+        std::vector<std::vector<bool>> identical = find_identical(corpus, rows, cols);
+
+        // Отсекаем пары, которые заведомо не дотягивают до порога.
+        //   min_cmn_substr_size -- наименьшая длина общей подстроки,
+        //   при которой cmn_substr_size * 100 >= max_size * percent.
+        //   Если она больше меньшего файла, пара точно не похожа. Если
+        //   она не меньше kSketchGuaranteedLen, а отпечатки файлов не
+        //   пересекаются, общей подстроки такой длины тоже нет.
+        SketchIndex sketch_index;
+        for (size_t col = 0; col < cols.size(); ++col) {
+            sketch_index.add(col, sketches[cols[col]]);
+        }
+        sketch_index.build();
+
+        // char, а не bool: ниже элементы пишутся из разных потоков.
+        std::vector<std::vector<char>> needs_engine(rows.size(), std::vector<char>(cols.size(), false));
+        std::vector<std::pair<size_t, size_t>> candidates;
+        std::vector<bool> is_candidate;
+        for (size_t row = 0; row < rows.size(); ++row) {
+            is_candidate.assign(cols.size(), false);
+            sketch_index.find_candidates(sketches[rows[row]], is_candidate);
+            for (size_t col = 0; col < cols.size(); ++col) {
+                if (identical[row][col]) {
+                    continue;
+                }
+                const size_t size1 = corpus.file(rows[row]).size;
+                const size_t size2 = corpus.file(cols[col]).size;
+                const size_t min_cmn_substr_size = (std::max(size1, size2) * percent_for_not_eq + 99) / 100;
+                if (min_cmn_substr_size > std::min(size1, size2)) {
+                    stats.add(Counter::kPairsPrunedBySize);
+                    continue;
+                }
+                const bool sketched = std::max(size1, size2) <= options.max_sketched_size;
+                if (min_cmn_substr_size >= kSketchGuaranteedLen && sketched && !is_candidate[col]) {
+                    stats.add(Counter::kPairsPrunedBySketch);
+                    continue;
+                }
+                needs_engine[row][col] = true;
+                candidates.emplace_back(row, col);
+            }
+        }
+
+        candidates_timer.stop();
+
+        // Файлы, отпечатки которых взяты из кеша, ещё не прочитаны.
+        //   Читаем только те, что участвуют в точном сравнении.
+        std::vector<size_t> compared_items;
+        std::vector<bool> is_compared(corpus.size(), false);
+        for (auto [row, col]: candidates) {
+            for (size_t id: {rows[row], cols[col]}) {
+                if (!is_compared[id]) {
+                    is_compared[id] = true;
+                    compared_items.push_back(id);
+                }
+            }
+        }
+        corpus.load(compared_items);
+
+        // Для оставшихся пар проверяем, есть ли вообще общая подстрока
+        //   нужной длины. Это линейный проход по паре без построения
+        //   индекса; пары ниже порога обычно отбрасываются здесь, и
+        //   индекс для файла второй директории может не понадобиться.
+        uint64_t candidates_size = 0;
+        for (auto [row, col]: candidates) {
+            candidates_size += corpus.file(rows[row]).size + corpus.file(cols[col]).size;
+        }
+        PhaseTimer substr_check_timer(Phase::kSubstrCheck, candidates_size);
+        parallel_for(candidates.size(), options.num_threads, [&](size_t candidate, size_t) {
+            auto [row, col] = candidates[candidate];
+            std::span<const uint8_t> content1 = corpus.content(rows[row]);
+            std::span<const uint8_t> content2 = corpus.content(cols[col]);
+            const size_t min_cmn_substr_size = (std::max(content1.size(), content2.size()) * percent_for_not_eq + 99) / 100;
+            if (!has_cmn_substr_of_len(content1, content2, min_cmn_substr_size)) {
+                needs_engine[row][col] = false;
+                stats.add(Counter::kPairsPrunedBySubstrCheck);
+            }
+        });
+        substr_check_timer.stop();
+
+        // Остальные пары сравниваем по наидлиннейшей общей подстроке.
+        //   Пары независимы, считаем их на всех ядрах, результаты
+        //   складываем в матрицу.
+        std::vector<std::vector<size_t>> cmn_substr_sizes(rows.size(), std::vector<size_t>(cols.size(), 0));
+        uint64_t engine_size = 0;
+        for (auto [row, col]: candidates) {
+            if (needs_engine[row][col]) {
+                engine_size += corpus.file(rows[row]).size + corpus.file(cols[col]).size;
+            }
+        }
+        PhaseTimer engine_timer(Phase::kEngine, engine_size);
+        // Потоков движка не больше, чем индексов самого большого
+        //   задания помещается в бюджет, иначе память росла бы с
+        //   числом ядер. Задания, которые не помещаются и в весь
+        //   бюджет, считаются без индекса и в счёт не идут.
+        size_t max_job_bytes = 0;
+        for (auto [row, col]: candidates) {
+            if (!needs_engine[row][col]) {
+                continue;
+            }
+            const size_t text_size = corpus.file(cols[col]).size;
+            size_t job_bytes = 0;
+            if (options.engine == Engine::kSuffixAutomaton) {
+                job_bytes = text_size < SuffixAutomaton::kMaxTextSize ? SuffixAutomaton::estimate_bytes(text_size) : 0;
+            } else {
+                job_bytes = estimate_lcs_workspace_bytes(corpus.file(rows[row]).size, text_size);
+            }
+            if (options.max_memory == 0 || job_bytes <= options.max_memory) {
+                max_job_bytes = std::max(max_job_bytes, job_bytes);
+            }
+        }
+        size_t num_engine_threads = options.num_threads;
+        if (options.max_memory != 0 && max_job_bytes != 0) {
+            num_engine_threads = std::clamp<size_t>(options.max_memory / max_job_bytes, 1, options.num_threads);
+        }
+        const size_t worker_memory = options.max_memory == 0 ? SIZE_MAX : options.max_memory / num_engine_threads;
+        auto bounded_cmn_substr_size = [&](size_t row, size_t col) {
+            stats.add(Counter::kPairsBounded);
+            return bounded_cmn_substr_len(corpus.content(rows[row]), corpus.content(cols[col]), static_cast<size_t>(percent_for_not_eq));
+        };
+        if (options.engine == Engine::kSuffixAutomaton) {
+            // Задание -- файл второй директории: индекс по нему строится
+            //   один раз, с ним сравниваются все файлы первой.
+            parallel_for(cols.size(), num_engine_threads, [&](size_t col, size_t) {
+                bool has_pairs_left = false;
+                for (size_t row = 0; row < rows.size(); ++row) {
+                    has_pairs_left = has_pairs_left || needs_engine[row][col];
+                }
+                if (!has_pairs_left) {
+                    return;
+                }
+
+                const size_t text_size = corpus.file(cols[col]).size;
+                if (text_size >= SuffixAutomaton::kMaxTextSize || SuffixAutomaton::estimate_bytes(text_size) > worker_memory) {
+                    for (size_t row = 0; row < rows.size(); ++row) {
+                        if (needs_engine[row][col]) {
+                            cmn_substr_sizes[row][col] = bounded_cmn_substr_size(row, col);
+                        }
+                    }
+                    return;
+                }
+
+                SuffixAutomaton index(corpus.content(cols[col]));
+                for (size_t row = 0; row < rows.size(); ++row) {
+                    if (needs_engine[row][col]) {
+                        cmn_substr_sizes[row][col] = index.longest_cmn_substr_len(corpus.content(rows[row]));
+                    }
+                }
+            });
+        } else {
+            // Суффиксный массив строится на пару, задание -- пара.
+            //   Временные массивы берутся из рабочей памяти потока: она
+            //   растёт до самой большой пары и дальше переиспользуется.
+            // Когда пар намного меньше, чем потоков, свободные потоки
+            //   строят суффиксный массив пары вместе, и каждой паре
+            //   достаётся их доля памяти.
+            size_t num_engine_pairs = 0;
+            for (auto [row, col]: candidates) {
+                num_engine_pairs += needs_engine[row][col] ? 1 : 0;
+            }
+            size_t threads_per_pair = num_engine_threads / std::max<size_t>(num_engine_pairs, 1);
+            if (threads_per_pair < kMinSuffixArrayThreads) {
+                threads_per_pair = 1;
+            }
+            const size_t pair_memory = worker_memory == SIZE_MAX ? SIZE_MAX : worker_memory * threads_per_pair;
+            std::vector<Workspace> workspaces(num_engine_threads);
+            parallel_for(rows.size() * cols.size(), num_engine_threads, [&](size_t pair, size_t worker) {
+                size_t row = pair / cols.size();
+                size_t col = pair % cols.size();
+                if (needs_engine[row][col]) {
+                    std::span<const uint8_t> content1 = corpus.content(rows[row]);
+                    std::span<const uint8_t> content2 = corpus.content(cols[col]);
+                    size_t num_pair_threads = threads_per_pair;
+                    size_t workspace_size = estimate_lcs_workspace_bytes(content1.size(), content2.size(), num_pair_threads);
+                    if (workspace_size > pair_memory) {
+                        num_pair_threads = 1;
+                        workspace_size = estimate_lcs_workspace_bytes(content1.size(), content2.size());
+                    }
+                    if (workspace_size > pair_memory) {
+                        cmn_substr_sizes[row][col] = bounded_cmn_substr_size(row, col);
+                        return;
+                    }
+                    Workspace& workspace = workspaces[worker];
+                    workspace.reserve(workspace_size);
+                    cmn_substr_sizes[row][col] = get_longest_cmn_substr_len(content1, content2, workspace, num_pair_threads);
+                }
+            });
+        }
+
+        engine_timer.stop();
+
+        for (size_t row = 0; row < rows.size(); ++row) {
+            for (size_t col = 0; col < cols.size(); ++col) {
+                if (identical[row][col]) {
+                    matches.push_back(PairMatch{row, col, true, 100});
+                    continue;
+                }
+                if (!needs_engine[row][col]) {
+                    continue;
+                }
+                stats.add(Counter::kPairsCompared);
+                size_t cmn_substr_size = cmn_substr_sizes[row][col];
+                size_t max_size = std::max(corpus.file(rows[row]).size, corpus.file(cols[col]).size);
+                // cmn_substr_size * 100 / max_len < percent_for_not_eq
+                //  Если процент меньше, то файлы считаются разными.
+                //  Избегаем округлений, работая с целыми числами.
+                //  Размеры не могут быть оба нулевыми: пустые файлы
+                //  одинаковы и уже отсеяны выше. Отсечённые пары до
+                //  порога не дотягивают.
+                if (cmn_substr_size * 100 >= max_size * percent_for_not_eq) {
+                    matches.push_back(PairMatch{row, col, false, cmn_substr_size * 100 / max_size});
+                    stats.add(Counter::kPairsSimilar);
+                }
+            }
+        }
+        return matches;
+    }
+
+    std::vector<PairMatch> compare_distinct_files_by_chunks(const Corpus& corpus, std::span<const ChunkSet> chunk_sets, std::span<const size_t> rows, std::span<const size_t> cols, const ComparisonOptions& options) {
+        const int percent_for_not_eq = options.percent_for_not_eq;
+        std::vector<PairMatch> matches;
+        Stats& stats = Stats::global();
+        PhaseTimer candidates_timer(Phase::kCandidates);
+        std::vector<std::vector<bool>> identical = find_identical(corpus, rows, cols);
+        ChunkIndex chunk_index;
+        for (size_t col = 0; col < cols.size(); ++col) {
+            chunk_index.add(col, chunk_sets[cols[col]]);
+        }
+        chunk_index.build();
+        candidates_timer.stop();
+
+        // Один проход по кускам каждого файла первой директории
+        //   даёт общие байты сразу со всеми файлами второй. Пары, у
+        //   которых общих кусков нет, в индексе не встречаются вовсе.
+        uint64_t rows_size = 0;
+        for (size_t id: rows) {
+            rows_size += corpus.file(id).size;
+        }
+        PhaseTimer engine_timer(Phase::kEngine, rows_size);
+        std::vector<std::vector<size_t>> shared_sizes(rows.size());
+        parallel_for(rows.size(), options.num_threads, [&](size_t row, size_t) {
+            shared_sizes[row].assign(cols.size(), 0);
+            chunk_index.add_shared_sizes(chunk_sets[rows[row]], shared_sizes[row]);
+        });
+        engine_timer.stop();
+
+        for (size_t row = 0; row < rows.size(); ++row) {
+            for (size_t col = 0; col < cols.size(); ++col) {
+                if (identical[row][col]) {
+                    matches.push_back(PairMatch{row, col, true, 100});
+                    continue;
+                }
+                stats.add(Counter::kPairsCompared);
+                // Общих байт не больше меньшего файла, как и у общей
+                //   подстроки, поэтому процент и порог те же: доля
+                //   общих байт от большего файла.
+                const size_t shared_size = shared_sizes[row][col];
+                const size_t max_size = std::max(corpus.file(rows[row]).size, corpus.file(cols[col]).size);
+                if (shared_size * 100 >= max_size * percent_for_not_eq) {
+                    matches.push_back(PairMatch{row, col, false, shared_size * 100 / max_size});
+                    stats.add(Counter::kPairsSimilar);
+                }
+            }
+        }
+        return matches;
+    }
+}
+
+std::vector<PairMatch> compare_files(Corpus& corpus, std::span<const Sketch> sketches, std::span<const size_t> rows, std::span<const size_t> cols, const ComparisonOptions& options) {
+    return compare_classes(corpus, rows, cols, [&](std::span<const size_t> distinct_rows, std::span<const size_t> distinct_cols) {
+        return compare_distinct_files(corpus, sketches, distinct_rows, distinct_cols, options);
+    });
+}
+
+std::vector<PairMatch> compare_files_by_chunks(const Corpus& corpus, std::span<const ChunkSet> chunk_sets, std::span<const size_t> rows, std::span<const size_t> cols, const ComparisonOptions& options) {
+    return compare_classes(corpus, rows, cols, [&](std::span<const size_t> distinct_rows, std::span<const size_t> distinct_cols) {
+        return compare_distinct_files_by_chunks(corpus, chunk_sets, distinct_rows, distinct_cols, options);
+    });
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "chunking.hpp"
+#include "corpus.hpp"
+#include "sketch.hpp"
+
+enum class Engine {
+    // Суффиксный автомат по файлу второй директории, строится
+    //   один раз на все файлы первой.
+    kSuffixAutomaton,
+    // Суффиксный массив конкатенации, строится для каждой пары.
+    kSuffixArray,
+};
+
+enum class Metric {
+    // Наидлиннейшая общая подстрока, делённая на размер большего
+    //   файла. Считается движком Engine.
+    kLongestCmnSubstr,
+    // Сколько байт большего файла покрыто кусками (chunking.hpp),
+    //   которые есть и в другом файле. Учитывает все общие места,
+    //   а не одно самое длинное, и считается одним проходом по
+    //   кускам без суффиксных структур.
+    kSharedChunks,
+};
+
+struct ComparisonOptions {
+    int percent_for_not_eq = 100;
+    Engine engine = Engine::kSuffixAutomaton;
+    Metric metric = Metric::kLongestCmnSubstr;
+    size_t num_threads = 1;
+    // Бюджет памяти на индексы движка, 0 -- без ограничения. Потоков
+    //   движка не больше, чем самых больших индексов помещается в
+    //   бюджет, и он делится поровну между ними. Пары, индекс для
+    //   которых в долю потока не помещается, считаются
+    //   bounded_cmn_substr_len с тем же результатом, но медленнее.
+    size_t max_memory = 0;
+    // Файлы больше этого без отпечатков (их отпечаток занимает
+    //   порядка половины размера файла), пары с ними отпечатками
+    //   не отсекаются.
+    size_t max_sketched_size = SIZE_MAX;
+};
+
+// Пара одинаковых или похожих файлов. row и col -- позиции
+//   в списках, переданных compare_files.
+struct PairMatch {
+    size_t row = 0;
+    size_t col = 0;
+    bool identical = false;
+    // Процент сходства, для одинаковых 100.
+    size_t percent = 0;
+};
+
+// Сравнивает каждый файл rows (первая директория) с каждым
+//   файлом cols (вторая) и возвращает одинаковые и похожие пары
+//   в порядке (row, col). Остальные пары не похожи.
+// Нужны размеры и хеши всех файлов и их отпечатки sketches[id].
+//   Содержимое дочитывается только для пар, которые нельзя
+//   отсечь без точного сравнения.
+// Побайтово одинаковые файлы внутри rows и внутри cols
+//   сравниваются один раз, результат раздаётся всем копиям.
+// Подматрицы можно считать отдельно: результат пары не зависит
+//   от остальных файлов. Так режим наблюдения пересчитывает
+//   строку или столбец изменённого файла.
+std::vector<PairMatch> compare_files(Corpus& corpus, std::span<const Sketch> sketches, std::span<const size_t> rows, std::span<const size_t> cols, const ComparisonOptions& options);
+
+// То же по мере kSharedChunks. Нужны размеры, хеши и куски
+//   chunk_sets[id] всех файлов, содержимое не читается.
+std::vector<PairMatch> compare_files_by_chunks(const Corpus& corpus, std::span<const ChunkSet> chunk_sets, std::span<const size_t> rows, std::span<const size_t> cols, const ComparisonOptions& options);
@@ -0,0 +1,64 @@
+#include "content_hash.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace {
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+
+    uint64_t load_u64(const uint8_t* data) {
+        uint64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Раунд из xxHash64: каждое 8-байтовое слово перемешивается
+    //   с аккумулятором умножениями и циклическим сдвигом.
+    uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = std::rotl(acc, 31);
+        acc *= kPrime1;
+        return acc;
+    }
+
+    // Финальное перемешивание из MurmurHash3, чтобы каждый бит
+    //   результата зависел от каждого бита аккумулятора.
+    uint64_t avalanche(uint64_t value) {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+}
+
+ContentHash hash_content(std::span<const uint8_t> data) {
+    // Две независимые полосы по 64 бита, каждая читает своё
+    //   слово из блока в 16 байт. Полосы не зависят друг от
+    //   друга внутри цикла, процессор считает их параллельно.
+    uint64_t low  = kPrime3 ^ data.size();
+    uint64_t high = kPrime1 + data.size();
+
+    size_t pos = 0;
+    for (; pos + 16 <= data.size(); pos += 16) {
+        low  = round(low,  load_u64(data.data() + pos));
+        high = round(high, load_u64(data.data() + pos + 8));
+    }
+
+    // Хвост дополняем нулями. Файлы с разным количеством нулей
+    //   в конце не склеятся, длина уже вошла в начальное значение.
+    if (pos < data.size()) {
+        uint8_t tail[16] = {};
+        std::memcpy(tail, data.data() + pos, data.size() - pos);
+        low  = round(low,  load_u64(tail));
+        high = round(high, load_u64(tail + 8));
+    }
+
+    ContentHash result;
+    result.low  = avalanche(low + std::rotl(high, 17));
+    result.high = avalanche(high ^ (low * kPrime3));
+    return result;
+}
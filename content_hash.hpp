@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+// 128-битный хеш содержимого файла. Нужен, чтобы находить
+//   побайтово одинаковые файлы без построения суффиксного
+//   массива: одинаковые файлы имеют одинаковые размер и хеш.
+//   Криптографической стойкости не требуется, файлы не
+//   подбирают специально, а 128 бит делают случайную
+//   коллизию практически невозможной.
+struct ContentHash {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const ContentHash& other) const = default;
+};
+
+ContentHash hash_content(std::span<const uint8_t> data);
+
+// Версия hash_content. Хеши хранятся в кеше отпечатков между
+//   запусками, и при любом изменении функции (констант, порядка
+//   перемешивания) версию нужно увеличить, иначе старый кеш
+//   выдаст хеши, не совпадающие с новыми, и одинаковые файлы
+//   будут найдены неверно.
+constexpr uint32_t kContentHashVersion = 1;
+
+// Ключ для поиска одинаковых файлов: размер и хеш.
+struct ContentKey {
+    size_t size = 0;
+    ContentHash hash;
+
+    bool operator==(const ContentKey& other) const = default;
+};
+
+template<>
+struct std::hash<ContentKey> {
+    size_t operator()(const ContentKey& key) const {
+        // Хеш уже хорошо перемешан, достаточно взять его часть.
+        return static_cast<size_t>(key.hash.low ^ key.size);
+    }
+};
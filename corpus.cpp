@@ -0,0 +1,343 @@
+#include "corpus.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "parallel.hpp"
+#include "stats.hpp"
+
+namespace {
+    // Читаем крупными кусками: на каждый вызов read() приходится
+    //   мегабайты данных, накладные расходы на вызов не видны.
+    constexpr size_t kReadChunkSize = 4 * 1024 * 1024;
+
+    // На сколько байт чтение может опередить обработку. Для файлов
+    //   в буфере это только ограничение забегания вперёд, а для
+    //   отображённых -- объём, который ядро подкачивает заранее:
+    //   без предела подкачка вытесняла бы ещё не обработанное.
+    constexpr size_t kPrefetchSize = 64 * 1024 * 1024;
+
+    // Очередь прочитанных, но ещё не обработанных файлов между
+    //   читающим потоком и обрабатывающими.
+    class LoadQueue {
+    public:
+        // Ждёт, пока необработанного наберётся меньше kPrefetchSize.
+        //   Один файл проходит всегда, даже если он больше предела.
+        //   false, если очередь закрыта и файл класть не нужно.
+        bool push(size_t id, size_t size) {
+            std::unique_lock lock(mutex_);
+            not_full_.wait(lock, [&] {
+                return closed_ || pending_ == 0 || pending_size_ + size <= kPrefetchSize;
+            });
+            if (closed_) {
+                return false;
+            }
+            ids_.push_back(id);
+            ++pending_;
+            pending_size_ += size;
+            not_empty_.notify_one();
+            return true;
+        }
+
+        // false, если файлов больше не будет.
+        bool pop(size_t& id) {
+            std::unique_lock lock(mutex_);
+            not_empty_.wait(lock, [&] {
+                return closed_ || finished_ || !ids_.empty();
+            });
+            if (closed_ || ids_.empty()) {
+                return false;
+            }
+            id = ids_.front();
+            ids_.pop_front();
+            return true;
+        }
+
+        // Файл, взятый pop, обработан.
+        void done(size_t size) {
+            std::lock_guard lock(mutex_);
+            --pending_;
+            pending_size_ -= size;
+            not_full_.notify_all();
+        }
+
+        // Ждёт, пока не обработаны все положенные файлы.
+        void wait_idle() {
+            std::unique_lock lock(mutex_);
+            not_full_.wait(lock, [&] {
+                return closed_ || pending_ == 0;
+            });
+        }
+
+        // Читающий поток положил всё.
+        void finish() {
+            std::lock_guard lock(mutex_);
+            finished_ = true;
+            not_empty_.notify_all();
+        }
+
+        // Ошибка с одной из сторон: остальные бросают работу.
+        void close() {
+            std::lock_guard lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::deque<size_t> ids_;
+        // Положено, но ещё не обработано (в очереди и в работе).
+        size_t pending_ = 0;
+        size_t pending_size_ = 0;
+        bool finished_ = false;
+        bool closed_ = false;
+    };
+}
+
+Corpus::~Corpus() {
+    for (CorpusFile& file: files_) {
+        unmap_file(file);
+    }
+}
+
+size_t Corpus::add_file(const fs::path& path) {
+    CorpusFile file;
+    file.path = path;
+    files_.push_back(std::move(file));
+    return files_.size() - 1;
+}
+
+void Corpus::grow_arena(size_t min_capacity) {
+    size_t new_capacity = std::max(min_capacity, arena_capacity_ * 2);
+    auto new_arena = std::make_unique_for_overwrite<uint8_t[]>(new_capacity);
+    if (arena_size_ != 0) {
+        std::memcpy(new_arena.get(), arena_.get(), arena_size_);
+    }
+    arena_ = std::move(new_arena);
+    arena_capacity_ = new_capacity;
+}
+
+void Corpus::read_file(CorpusFile& file, const std::function<void()>& before_grow) {
+    file.offset = arena_size_;
+
+    // Двоичный режим: в текстовом на некоторых платформах
+    //   переводы строк преобразуются, а нам нужны сами байты.
+    std::ifstream stream(file.path, std::ios::binary);
+    while (stream) {
+        if (arena_size_ == arena_capacity_) {
+            // Файл оказался больше, чем был при подсчёте размера.
+            //   Редкий случай, можно переложить буфер.
+            before_grow();
+            grow_arena(arena_size_ + kReadChunkSize);
+        }
+        size_t to_read = std::min(kReadChunkSize, arena_capacity_ - arena_size_);
+        stream.read(reinterpret_cast<char*>(arena_.get() + arena_size_), static_cast<std::streamsize>(to_read));
+        arena_size_ += static_cast<size_t>(stream.gcount());
+    }
+
+    file.size = arena_size_ - file.offset;
+    file.loaded = true;
+}
+
+bool Corpus::map_file(CorpusFile& file) {
+    int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // Размер берём у открытого файла: отображать больше, чем
+    //   есть в файле, нельзя.
+    struct stat info;
+    size_t size = 0;
+    void* mapping = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        size = static_cast<size_t>(info.st_size);
+        mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // Отображение остаётся действительным и после закрытия.
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    file.mapping = static_cast<const uint8_t*>(mapping);
+    file.offset = 0;
+    file.size = size;
+    file.loaded = true;
+    return true;
+}
+
+void Corpus::unmap_file(CorpusFile& file) {
+    if (file.mapping != nullptr) {
+        ::munmap(const_cast<uint8_t*>(file.mapping), file.size);
+        file.mapping = nullptr;
+    }
+}
+
+void Corpus::load() {
+    for (CorpusFile& file: files_) {
+        unmap_file(file);
+    }
+    arena_.reset();
+    arena_size_ = 0;
+    arena_capacity_ = 0;
+    removed_size_ = 0;
+    for (CorpusFile& file: files_) {
+        file.loaded = false;
+    }
+
+    std::vector<size_t> ids(files_.size());
+    for (size_t id = 0; id < files_.size(); ++id) {
+        ids[id] = id;
+    }
+    load(ids);
+}
+
+void Corpus::load(std::span<const size_t> ids) {
+    load(ids, {}, 1);
+}
+
+void Corpus::load(std::span<const size_t> ids, const std::function<void(size_t)>& on_loaded, size_t num_threads) {
+    PhaseTimer timer(Phase::kIngest);
+    // Сразу выделяем буфер на все файлы, чтобы он не
+    //   переезжал при чтении. Размер файла мог поменяться
+    //   с момента запроса, потому это только подсказка.
+    //   Запас в один кусок чтения нужен последнему файлу:
+    //   конец файла видно, только попытавшись прочитать
+    //   ещё, и на это нужно свободное место.
+    size_t total_size = arena_size_ + kReadChunkSize;
+    std::vector<size_t> file_sizes(ids.size(), 0);
+    for (size_t item = 0; item < ids.size(); ++item) {
+        if (files_[ids[item]].loaded) {
+            continue;
+        }
+        std::error_code error;
+        uintmax_t file_size = fs::file_size(files_[ids[item]].path, error);
+        if (!error) {
+            file_sizes[item] = static_cast<size_t>(file_size);
+            if (map_min_size_ == 0 || file_sizes[item] < map_min_size_) {
+                total_size += file_sizes[item];
+            }
+        }
+    }
+    if (removed_size_ > (arena_size_ - removed_size_) / 2 + kReadChunkSize) {
+        compact_arena(total_size - arena_size_);
+    } else if (total_size > arena_capacity_) {
+        grow_arena(total_size);
+    }
+
+    // Читающий поток кладёт в очередь номера элементов ids. Буфер
+    //   он увеличивает, только дождавшись обработки всего, что
+    //   положил: обрабатывающие потоки в это время буфер не читают.
+    LoadQueue queue;
+    std::vector<uint8_t> is_read(ids.size(), 0);
+    std::exception_ptr read_error;
+    std::thread reader([&] {
+        try {
+            for (size_t item = 0; item < ids.size(); ++item) {
+                CorpusFile& file = files_[ids[item]];
+                if (!file.loaded) {
+                    const bool mapped = map_min_size_ != 0 && file_sizes[item] >= map_min_size_ && map_file(file);
+                    if (mapped) {
+                        // Ядро подкачивает файл, пока обрабатываются
+                        //   предыдущие.
+                        ::madvise(const_cast<uint8_t*>(file.mapping), file.size, MADV_WILLNEED);
+                    } else {
+                        read_file(file, [&] {
+                            queue.wait_idle();
+                        });
+                    }
+                    is_read[item] = 1;
+                    timer.add_bytes(file.size);
+                    Stats::global().add(Counter::kFiles);
+                }
+                if (!queue.push(item, file.size)) {
+                    return;
+                }
+            }
+        } catch (...) {
+            read_error = std::current_exception();
+            queue.close();
+            return;
+        }
+        queue.finish();
+    });
+
+    num_threads = std::max<size_t>(num_threads, 1);
+    try {
+        parallel_for(num_threads, num_threads, [&](size_t, size_t) {
+            size_t item = 0;
+            while (queue.pop(item)) {
+                const size_t id = ids[item];
+                try {
+                    if (is_read[item]) {
+                        files_[id].hash = hash_content(content(id));
+                    }
+                    if (on_loaded) {
+                        on_loaded(id);
+                    }
+                } catch (...) {
+                    queue.close();
+                    throw;
+                }
+                queue.done(files_[id].size);
+            }
+        });
+    } catch (...) {
+        queue.close();
+        reader.join();
+        throw;
+    }
+    reader.join();
+    if (read_error) {
+        std::rethrow_exception(read_error);
+    }
+}
+
+void Corpus::set_fingerprint(size_t id, size_t size, const ContentHash& hash) {
+    files_[id].size = size;
+    files_[id].hash = hash;
+}
+
+void Corpus::remove_file(size_t id) {
+    CorpusFile& file = files_[id];
+    if (file.mapping != nullptr) {
+        unmap_file(file);
+    } else if (file.loaded) {
+        removed_size_ += file.size;
+    }
+    file.loaded = false;
+}
+
+void Corpus::compact_arena(size_t extra) {
+    const size_t new_capacity = arena_size_ - removed_size_ + extra;
+    auto new_arena = std::make_unique_for_overwrite<uint8_t[]>(new_capacity);
+    size_t new_size = 0;
+    for (CorpusFile& file: files_) {
+        if (!file.loaded || file.mapping != nullptr) {
+            continue;
+        }
+        if (file.size != 0) {
+            std::memcpy(new_arena.get() + new_size, arena_.get() + file.offset, file.size);
+        }
+        file.offset = new_size;
+        new_size += file.size;
+    }
+    arena_ = std::move(new_arena);
+    arena_size_ = new_size;
+    arena_capacity_ = new_capacity;
+    removed_size_ = 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "content_hash.hpp"
+
+namespace fs {
+    using namespace std::filesystem;
+};
+
+struct CorpusFile {
+    fs::path path;
+    // Положение содержимого файла в общем буфере корпуса.
+    size_t offset = 0;
+    size_t size = 0;
+    ContentHash hash;
+    // Содержимое прочитано в буфер. Размер и хеш могут быть
+    //   известны и без этого, из кеша отпечатков.
+    bool loaded = false;
+    // Если не nullptr, содержимое не скопировано в буфер, а
+    //   отображено из файла в память (см. set_map_min_size).
+    const uint8_t* mapping = nullptr;
+
+    ContentKey key() const {
+        return ContentKey{size, hash};
+    }
+};
+
+// Содержимое всех сравниваемых файлов. Каждый файл читается
+//   ровно один раз в общий непрерывный буфер, дальше сравнения
+//   работают с отрезками этого буфера и на диск не ходят.
+class Corpus {
+public:
+    Corpus() = default;
+    ~Corpus();
+
+    Corpus(const Corpus&) = delete;
+    Corpus& operator=(const Corpus&) = delete;
+
+    // Файлы не меньше min_size не копируются в буфер, а
+    //   отображаются в память: страницы такого файла ядро может
+    //   вытеснить и прочитать заново, и память процесса не растёт
+    //   на размер файла. 0 -- всё читать в буфер. Действует на
+    //   следующие load().
+    void set_map_min_size(size_t min_size) {
+        map_min_size_ = min_size;
+    }
+
+    // Добавляет файл и возвращает его номер в корпусе.
+    //   Читается файл только в load().
+    size_t add_file(const fs::path& path);
+
+    // Читает все добавленные файлы и считает их хеши.
+    void load();
+    // То же только для файлов ids, ещё не прочитанных. Уже
+    //   прочитанные файлы остаются в буфере.
+    void load(std::span<const size_t> ids);
+    // То же, но чтение идёт конвейером: отдельный поток читает
+    //   файлы по порядку, а num_threads потоков тем временем
+    //   считают хеши уже прочитанных и вызывают on_loaded(id) для
+    //   каждого файла из ids. Так обработка файла идёт, пока с
+    //   диска читаются следующие, и время стремится к большему из
+    //   времён чтения и обработки, а не к их сумме.
+    // В on_loaded можно читать содержимое только файла id: буфер
+    //   может переехать, пока обрабатываются другие файлы.
+    void load(std::span<const size_t> ids, const std::function<void(size_t)>& on_loaded, size_t num_threads);
+
+    // Размер и хеш файла, известные без чтения, например из
+    //   кеша. Содержимое можно дочитать позже через load(ids).
+    void set_fingerprint(size_t id, size_t size, const ContentHash& hash);
+
+    // Файл больше не нужен. Номера остальных файлов не меняются,
+    //   место в буфере освобождается при следующих load(ids),
+    //   когда освободившегося набирается много.
+    void remove_file(size_t id);
+
+    size_t size() const {
+        return files_.size();
+    }
+
+    const CorpusFile& file(size_t id) const {
+        return files_[id];
+    }
+
+    // Отрезок действителен, пока жив корпус и не вызван load().
+    std::span<const uint8_t> content(size_t id) const {
+        assert(files_[id].loaded);
+        if (files_[id].mapping != nullptr) {
+            return std::span<const uint8_t>(files_[id].mapping, files_[id].size);
+        }
+        return std::span<const uint8_t>(arena_.get() + files_[id].offset, files_[id].size);
+    }
+
+private:
+    // Дочитывает файл в конец буфера, при необходимости увеличивая
+    //   буфер. Перед увеличением вызывается before_grow: другие
+    //   потоки в это время могут читать буфер.
+    void read_file(CorpusFile& file, const std::function<void()>& before_grow);
+    // Отображает файл в память. false, если не удалось: тогда
+    //   файл читается в буфер как обычно.
+    bool map_file(CorpusFile& file);
+    void unmap_file(CorpusFile& file);
+    void grow_arena(size_t min_capacity);
+    // Переносит прочитанные файлы в новый буфер без промежутков
+    //   от удалённых, оставляя место ещё на extra байт.
+    void compact_arena(size_t extra);
+
+    std::vector<CorpusFile> files_;
+    // Буфер не инициализируется нулями: всё равно будет перезаписан
+    //   содержимым файлов, а лишний проход по памяти не бесплатный.
+    std::unique_ptr<uint8_t[]> arena_;
+    size_t arena_size_ = 0;
+    size_t arena_capacity_ = 0;
+    // Сколько байт буфера занимают удалённые файлы.
+    size_t removed_size_ = 0;
+    size_t map_min_size_ = 0;
+};
@@ -0,0 +1,224 @@
+#include "fingerprint_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr char kMagic[8] = {'F', 'P', 'C', 'A', 'C', 'H', 'E', '\0'};
+    // Версия формата файла. Версии хеша и отпечатков -- отдельно,
+    //   в заголовке.
+    constexpr uint32_t kVersion = 2;
+    constexpr const char* kFileName = "fingerprints.bin";
+
+    // Формат: заголовок, затем записи подряд. Запись -- EntryHeader,
+    //   путь, дополненный нулями до кратного 8, и отпечаток. Все
+    //   части кратны 8 байтам, потому отпечатки в отображённом
+    //   файле выровнены и читаются на месте.
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t kgram_len;
+        uint32_t window;
+        uint32_t content_hash_version;
+        uint32_t sketch_version;
+        uint32_t reserved;
+        uint64_t num_entries;
+    };
+
+    struct EntryHeader {
+        uint64_t path_size;
+        uint64_t size;
+        int64_t mtime_ns;
+        uint64_t inode;
+        uint64_t device;
+        uint64_t hash_low;
+        uint64_t hash_high;
+        uint64_t sketch_size;
+    };
+
+    size_t round_up8(size_t value) {
+        return (value + 7) / 8 * 8;
+    }
+
+    std::string cache_key(const fs::path& path) {
+        std::error_code error;
+        fs::path absolute = fs::absolute(path, error);
+        return (error ? path : absolute).lexically_normal().string();
+    }
+}
+
+std::optional<FileStamp> stat_file(const fs::path& path) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return std::nullopt;
+    }
+    FileStamp stamp;
+    stamp.size = static_cast<uint64_t>(info.st_size);
+    stamp.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    stamp.inode = static_cast<uint64_t>(info.st_ino);
+    stamp.device = static_cast<uint64_t>(info.st_dev);
+    return stamp;
+}
+
+FingerprintCache::FingerprintCache(const fs::path& dir): dir_(dir), file_path_(dir / kFileName) {
+    map_file();
+    parse();
+}
+
+FingerprintCache::~FingerprintCache() {
+    if (mapping_ != nullptr) {
+        ::munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+    }
+}
+
+void FingerprintCache::map_file() {
+    int fd = ::open(file_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            mapping_ = static_cast<const uint8_t*>(mapping);
+            mapping_size_ = static_cast<size_t>(info.st_size);
+        }
+    }
+    // Отображение остаётся действительным и после закрытия.
+    ::close(fd);
+}
+
+void FingerprintCache::parse() {
+    Header header;
+    if (mapping_size_ < sizeof(header)) {
+        return;
+    }
+    std::memcpy(&header, mapping_, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.kgram_len != kSketchKgramLen || header.window != kSketchWindow ||
+        header.content_hash_version != kContentHashVersion || header.sketch_version != kSketchVersion) {
+        return;
+    }
+
+    // Размеры из файла проверяем перед каждым чтением: файл
+    //   мог быть обрезан или испорчен.
+    size_t pos = sizeof(header);
+    std::unordered_map<std::string, MappedEntry> entries;
+    for (uint64_t i = 0; i < header.num_entries; ++i) {
+        EntryHeader entry;
+        if (mapping_size_ - pos < sizeof(entry)) {
+            return;
+        }
+        std::memcpy(&entry, mapping_ + pos, sizeof(entry));
+        pos += sizeof(entry);
+
+        const size_t rest = mapping_size_ - pos;
+        if (entry.path_size > rest || entry.sketch_size > rest / sizeof(uint64_t) ||
+            round_up8(entry.path_size) + entry.sketch_size * sizeof(uint64_t) > rest) {
+            return;
+        }
+        std::string path(reinterpret_cast<const char*>(mapping_ + pos), entry.path_size);
+        pos += round_up8(entry.path_size);
+
+        MappedEntry& mapped = entries[std::move(path)];
+        mapped.stamp = FileStamp{entry.size, entry.mtime_ns, entry.inode, entry.device};
+        mapped.hash = ContentHash{entry.hash_low, entry.hash_high};
+        mapped.sketch = std::span<const uint64_t>(reinterpret_cast<const uint64_t*>(mapping_ + pos), entry.sketch_size);
+        pos += entry.sketch_size * sizeof(uint64_t);
+    }
+    mapped_ = std::move(entries);
+}
+
+bool FingerprintCache::lookup(const fs::path& path, const FileStamp& stamp, ContentHash& hash, Sketch& sketch) const {
+    auto it = mapped_.find(cache_key(path));
+    if (it == mapped_.end() || it->second.stamp != stamp) {
+        return false;
+    }
+    hash = it->second.hash;
+    sketch.assign(it->second.sketch.begin(), it->second.sketch.end());
+    return true;
+}
+
+void FingerprintCache::store(const fs::path& path, const FileStamp& stamp, const ContentHash& hash, const Sketch& sketch) {
+    stored_[cache_key(path)] = StoredEntry{stamp, hash, sketch};
+}
+
+bool FingerprintCache::save() {
+    std::error_code error;
+    fs::create_directories(dir_, error);
+    if (error) {
+        return false;
+    }
+
+    // Записи о файлах, которые с тех пор удалены или переписаны,
+    //   выбрасываем: в режиме наблюдения кеш сохраняется после
+    //   каждого изменения, и без этого копил бы записи обо всех
+    //   версиях и удалённых файлах.
+    std::erase_if(stored_, [](const auto& item) {
+        std::optional<FileStamp> stamp = stat_file(item.first);
+        return !stamp.has_value() || *stamp != item.second.stamp;
+    });
+
+    // Старые записи о файлах, которых в этом запуске не было,
+    //   сохраняем, если файлы не поменялись: сравниваемые
+    //   директории от запуска к запуску могут быть разными.
+    std::vector<std::pair<const std::string*, const MappedEntry*>> kept;
+    for (const auto& [path, entry]: mapped_) {
+        if (stored_.contains(path)) {
+            continue;
+        }
+        std::optional<FileStamp> stamp = stat_file(path);
+        if (stamp.has_value() && *stamp == entry.stamp) {
+            kept.emplace_back(&path, &entry);
+        }
+    }
+
+    fs::path temp_path = file_path_;
+    temp_path += ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+        Header header = {};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.kgram_len = kSketchKgramLen;
+        header.window = kSketchWindow;
+        header.content_hash_version = kContentHashVersion;
+        header.sketch_version = kSketchVersion;
+        header.num_entries = kept.size() + stored_.size();
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        auto write_entry = [&](const std::string& path, const FileStamp& stamp, const ContentHash& hash, std::span<const uint64_t> sketch) {
+            EntryHeader entry{path.size(), stamp.size, stamp.mtime_ns, stamp.inode, stamp.device, hash.low, hash.high, sketch.size()};
+            stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+            const char padding[8] = {};
+            stream.write(path.data(), static_cast<std::streamsize>(path.size()));
+            stream.write(padding, static_cast<std::streamsize>(round_up8(path.size()) - path.size()));
+            stream.write(reinterpret_cast<const char*>(sketch.data()), static_cast<std::streamsize>(sketch.size_bytes()));
+        };
+        for (auto [path, entry]: kept) {
+            write_entry(*path, entry->stamp, entry->hash, entry->sketch);
+        }
+        for (const auto& [path, entry]: stored_) {
+            write_entry(path, entry.stamp, entry.hash, entry.sketch);
+        }
+
+        stream.flush();
+        if (!stream) {
+            fs::remove(temp_path, error);
+            return false;
+        }
+    }
+
+    fs::rename(temp_path, file_path_, error);
+    if (error) {
+        fs::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
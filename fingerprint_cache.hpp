@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "content_hash.hpp"
+#include "corpus.hpp"
+#include "sketch.hpp"
+
+// Что известно о файле без чтения: если ничего из этого не
+//   поменялось, считаем, что не поменялось и содержимое. Так
+//   же решают make и rsync.
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint64_t inode = 0;
+    uint64_t device = 0;
+
+    bool operator==(const FileStamp& other) const = default;
+};
+
+std::optional<FileStamp> stat_file(const fs::path& path);
+
+// Кеш отпечатков файлов между запусками: хеш содержимого и
+//   отпечаток winnowing по абсолютному пути и FileStamp. Если
+//   файл не менялся, его не нужно читать, чтобы найти
+//   одинаковые файлы и отсечь непохожие пары. Читаются только
+//   изменённые файлы и те, что дошли до точного сравнения.
+// Кеш -- один файл в директории. Он отображается в память
+//   целиком, записи разбираются на месте, отпечатки копируются
+//   только для запрошенных файлов. Повреждённый файл или файл
+//   с другими параметрами или версиями хеша и отпечатков
+//   (kContentHashVersion, kSketchVersion) считается пустым.
+// Записывается во временный файл, который затем атомарно
+//   переименовывается, поэтому прерванный запуск или
+//   параллельный запуск кеш не портят.
+class FingerprintCache {
+public:
+    explicit FingerprintCache(const fs::path& dir);
+    ~FingerprintCache();
+
+    FingerprintCache(const FingerprintCache&) = delete;
+    FingerprintCache& operator=(const FingerprintCache&) = delete;
+
+    // Находит запись по пути и совпадающему FileStamp.
+    bool lookup(const fs::path& path, const FileStamp& stamp, ContentHash& hash, Sketch& sketch) const;
+
+    // Запоминает запись для сохранения.
+    void store(const fs::path& path, const FileStamp& stamp, const ContentHash& hash, const Sketch& sketch);
+
+    // Записывает новые записи и старые, файлы которых не
+    //   поменялись. false, если записать не удалось.
+    bool save();
+
+private:
+    struct MappedEntry {
+        FileStamp stamp;
+        ContentHash hash;
+        std::span<const uint64_t> sketch;
+    };
+
+    struct StoredEntry {
+        FileStamp stamp;
+        ContentHash hash;
+        Sketch sketch;
+    };
+
+    void map_file();
+    void parse();
+
+    fs::path dir_;
+    fs::path file_path_;
+    const uint8_t* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    std::unordered_map<std::string, MappedEntry> mapped_;
+    std::unordered_map<std::string, StoredEntry> stored_;
+};
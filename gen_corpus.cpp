@@ -0,0 +1,172 @@
+// Генератор пар директорий для замеров программы целиком.
+//
+// gen_corpus OUT_DIR [--files N] [--max-size BYTES] [--similarity PERCENT] [--seed N]
+//
+// В OUT_DIR/dir1 -- N файлов размером от max-size / 10 до
+//   max-size, половина случайные байты, половина похожи на текст.
+//   В OUT_DIR/dir2 на каждый файл первой директории по одному:
+//   - побайтовая копия;
+//   - похожий: общий отрезок в similarity процентов исходного
+//     файла, остальное новое, так что сходство около similarity;
+//   - копия с мутациями примерно через каждые 1000 байт;
+//   - несвязанный файл.
+//   Вид выбирается по очереди, имена во второй директории
+//   перемешаны, чтобы порядок имён ничего не подсказывал.
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arguments.hpp"
+#include "corpus.hpp"
+
+namespace {
+    struct GeneratorOptions {
+        fs::path out_dir;
+        size_t num_files = 24;
+        size_t max_size = 10 * 1024 * 1024;
+        size_t similarity = 70;
+        uint64_t seed = 1;
+    };
+
+    std::vector<uint8_t> make_random(size_t size, std::mt19937_64& rng) {
+        std::vector<uint8_t> data(size);
+        for (uint8_t& chr: data) {
+            chr = static_cast<uint8_t>(rng());
+        }
+        return data;
+    }
+
+    // Слова из небольшого словаря через пробелы и переводы строк:
+    //   частые короткие повторы, как в исходниках и логах.
+    std::vector<uint8_t> make_text(size_t size, std::mt19937_64& rng) {
+        std::vector<std::string> words(2000);
+        for (std::string& word: words) {
+            word.resize(2 + rng() % 8);
+            for (char& chr: word) {
+                chr = static_cast<char>('a' + rng() % 26);
+            }
+        }
+        std::vector<uint8_t> data;
+        data.reserve(size + 16);
+        while (data.size() < size) {
+            const std::string& word = words[std::min<size_t>(rng() % words.size(), rng() % words.size())];
+            data.insert(data.end(), word.begin(), word.end());
+            data.push_back(rng() % 12 == 0 ? '\n' : ' ');
+        }
+        data.resize(size);
+        return data;
+    }
+
+    std::vector<uint8_t> make_file(size_t size, bool text, std::mt19937_64& rng) {
+        return text ? make_text(size, rng) : make_random(size, rng);
+    }
+
+    std::vector<uint8_t> mutate(const std::vector<uint8_t>& data, size_t rate, std::mt19937_64& rng) {
+        std::vector<uint8_t> result;
+        result.reserve(data.size() + data.size() / rate + 1);
+        for (uint8_t chr: data) {
+            if (rng() % rate != 0) {
+                result.push_back(chr);
+            } else if (rng() % 2 == 0) {
+                result.push_back(static_cast<uint8_t>(rng()));
+            }
+        }
+        return result;
+    }
+
+    void write_file(const fs::path& path, const std::vector<uint8_t>& data) {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    void print_usage(std::string_view program_path) {
+        std::cout << "Usage: " << program_path << " OUT_DIR [--files N] [--max-size BYTES] [--similarity PERCENT] [--seed N]\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || std::string_view(argv[1]).starts_with("--")) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    GeneratorOptions options;
+    options.out_dir = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+        if (i + 1 == argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const std::optional<size_t> parsed = parse_size(argv[++i]);
+        if (!parsed.has_value()) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const uint64_t value = *parsed;
+        if (arg == "--files") {
+            options.num_files = static_cast<size_t>(value);
+        } else if (arg == "--max-size") {
+            options.max_size = std::max<size_t>(static_cast<size_t>(value), 10);
+        } else if (arg == "--similarity") {
+            options.similarity = std::min<size_t>(static_cast<size_t>(value), 100);
+        } else if (arg == "--seed") {
+            options.seed = value;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const fs::path dir1 = options.out_dir / "dir1";
+    const fs::path dir2 = options.out_dir / "dir2";
+    fs::remove_all(dir1);
+    fs::remove_all(dir2);
+    fs::create_directories(dir1);
+    fs::create_directories(dir2);
+
+    std::mt19937_64 rng(options.seed);
+    std::vector<size_t> dir2_names(options.num_files);
+    for (size_t i = 0; i < options.num_files; ++i) {
+        dir2_names[i] = i;
+    }
+    std::shuffle(dir2_names.begin(), dir2_names.end(), rng);
+
+    for (size_t i = 0; i < options.num_files; ++i) {
+        const bool text = i % 2 == 1;
+        const size_t size = options.max_size / 10 + rng() % (options.max_size - options.max_size / 10 + 1);
+        std::vector<uint8_t> original = make_file(size, text, rng);
+
+        std::vector<uint8_t> counterpart;
+        switch (i / 2 % 4) {
+        case 0:
+            counterpart = original;
+            break;
+        case 1: {
+            const size_t shared = size * options.similarity / 100;
+            const size_t start = rng() % (size - shared + 1);
+            counterpart = make_file(size - shared, text, rng);
+            counterpart.insert(counterpart.begin() + static_cast<ptrdiff_t>(rng() % (counterpart.size() + 1)), original.begin() + static_cast<ptrdiff_t>(start), original.begin() + static_cast<ptrdiff_t>(start + shared));
+            break;
+        }
+        case 2:
+            counterpart = mutate(original, 1000, rng);
+            break;
+        default:
+            counterpart = make_file(size, text, rng);
+            break;
+        }
+
+        write_file(dir1 / ("file" + std::to_string(i) + ".bin"), original);
+        write_file(dir2 / ("file" + std::to_string(dir2_names[i]) + ".bin"), counterpart);
+    }
+
+    std::cout << dir1.string() << ' ' << dir2.string() << '\n';
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include <filesystem>
@@ -5,465 +6,320 @@
 #include <fstream>
 #include <iostream>
 #include <cstdint>
-#include <unordered_set>
 #include <optional>
 #include <span>
+#include <unordered_map>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+#include "arguments.hpp"
+#include "chunking.hpp"
+#include "comparison.hpp"
+#include "content_hash.hpp"
+#include "corpus.hpp"
+#include "fingerprint_cache.hpp"
+#include "parallel.hpp"
+#include "report.hpp"
+#include "sketch.hpp"
+#include "stats.hpp"
+#include "watch.hpp"
 
 void print_usage(std::string_view program_path) {
-    std::cout << "Usage: " << program_path <<  " [folder1] [folder2]\n";
+    std::cout << "Usage: " << program_path <<  " [folder1] [folder2] [percent] [--engine sam|sa] [--metric lcs|chunks] [--threads N] [--max-memory SIZE[K|M|G]] [--cache DIR] [--watch] [--stats FILE] [--format text|sections|json|csv]\n";
+    std::cout << "       " << program_path <<  " [folder1] [percent] (--ref DIR)... [--ref-list FILE] [options]\n";
 }
 
-namespace fs {
-    using namespace std::filesystem;
+// Бюджет памяти по умолчанию -- половина физической памяти. Без
+//   него каждый поток строил бы свой индекс, и память росла бы с
+//   числом ядер.
+size_t default_max_memory() {
+    const long num_pages = ::sysconf(_SC_PHYS_PAGES);
+    const long page_size = ::sysconf(_SC_PAGE_SIZE);
+    if (num_pages <= 0 || page_size <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(num_pages) / 2 * static_cast<size_t>(page_size);
+}
+
+struct Options {
+    std::string_view dir1;
+    // Директории, с которыми сравнивается dir1. Обычно одна, вторая
+    //   из аргументов; с --ref и --ref-list -- сколько угодно, и
+    //   все сравниваются за один запуск с общим корпусом.
+    std::vector<std::string> ref_dirs;
+    int percent_for_not_eq = 100;
+    Engine engine = Engine::kSuffixAutomaton;
+    Metric metric = Metric::kLongestCmnSubstr;
+    size_t num_threads = default_num_threads();
+    // Бюджет памяти в байтах, 0 -- без ограничения.
+    size_t max_memory = default_max_memory();
+    // Директория кеша отпечатков между запусками, пусто -- без кеша.
+    std::string_view cache_dir;
+    // После отчёта следить за директориями и печатать изменения.
+    bool watch = false;
+    // Куда записать замеры по этапам в JSON, пусто -- не замерять.
+    std::string_view stats_path;
+    OutputFormat format = OutputFormat::kText;
 };
 
-void get_suffix_array(std::span<uint8_t> text, std::vector<size_t>& suffix_array, std::vector<size_t>& inv_suffix_array) {
-    // Алгоритм Манбера-Майерса. Строим суффиксный массив за
-    //   O(n log(n)) сортировкой зацикленных циклических сдвигов.
-    // Допишем нулевой символ в конец, который меньше всех остальных.
-    // Теперь суффикс из нулевого символа находится в начале массива.
-    // Лексикографический порядок суффиксов не изменится (к ним
-    //   просто дописался ноль):
-    //   если не один из двух суффиксов не был префиксом другого,
-    //   то в какой-то момент они начинают отличаться, до нуля
-    //   сравнение не доходит;
-    //   если был, то суффикс меньшей длины префикс суффикса большей,
-    //   раньше сравнение завершалось из-за разной длины строк, но
-    //   теперь у строки меньшей длины появляется нулевой символ
-    //   раньше.
-    // Теперь в конце суффиксов есть нулевой байт. Можем после этого
-    //   байта дописать любые строки, порядок суффиксов не изменится:
-    //   все суффиксы разной длины, потому там находится 0 в разных
-    //   позициях. До дописанной строки сравнение никогда не дойдет,
-    //   поскольку на первом нуле выяснится порядок, кто меньше. У
-    //   кого встретился ноль, то и меньше.
-    // Тогда допишем к суффиксам ноль, а потом недостающие символы
-    //   из начала, а затем зациклим эту строку, сделав бесконечной.
-    //   Достаточно отсортировать эти бесконечные строки по первым n
-    //   символам, где n -- длина строки, и всё будет готово. Давайте
-    //   отсортируем по первой степени двойки, которая больше или
-    //   равна n. Сортировать будем сортировками подсчётом за O(n),
-    //   количество сравниваемых строк -- n + 1, это O(n), будет
-    //   log_2(n) итераций. Потому O(n log(n)).
-    // Можно дописывать не нулевой символ, а строго меньший всех
-    //   остальных в строке. Все доказательства будут работать.
-    // Для нашей задачи можем дописать заведомо меньший символ
-    //   0x10.
-    // Пусть S_i -- номер отрезка совпадающих элементов i-го суффикса
-    //   после сортировки с k-ой итерации.
-    //   Как понять, что это такое? В результате любой сортировки
-    //   у нас сначала идут числа с наименьшим значением, затем
-    //   со вторым наибольшим и так далее. И числа с наименьшим,
-    //   если их было несколько, образуют отрезок. Аналогично числа
-    //   со вторым наименьшим значением и так далее.
-    //   Это же происходит и при лексикографической сортировке строк:
-    //     сначала сколько строк одинаковых, наименьших лексикографически,
-    //     затем строки вторые лексикогарфически и так далее. Внутри
-    //     отрезка находятся одинаковые строки, т.е. это просто одинаковые
-    //     строки из набора. Пронумеруем эти отрезки с нуля, по индексу из
-    //     исходного массива будем получать номер такого отрезка, где
-    //     элемент оказался.
-    //   В нашем случае мы сортируем по первым 2^k символам, потому по первым
-    //     k символам строки совпадают. И сами строки не храним, а храним их
-    //     начала в исходной строке.
-    //   Это ещё называют лексикографическим именем (алгоритм
-    //   Каркайнена-Сандерса, построение суфмассива за O(n)), компонентой
-    //   эквивалентности в разборах нашего алгоритма, что имеет смысл, т.к.
-    //    внутри отрезка все элементы равны.
-    // Пусть M_j -- отсортированный массив с началами суффиксов с итерации k.
-    // На итерации k + 1 надо отсортировать пары (S_i, S_{i + 2^k}).
-    //   Отсортировать по второй половине легко: возьмём M'_j = M_{j + 2^k},
-    //   зациклив индекс. Почему это то же самое, что отсортировать по второй
-    //   половине? TODO: посмотреть разбор этого алгоса, дописать. Сейчас я
-    //   TODO: просто знаю, что надо делать.
-    // Чтобы выучить алгоритм, рекомендую записать эти шаги, держать их в
-    //   голове.
-
-    // Этапы:
-    //  1) дополнение строки,
-    //  1.1) почему дополняем, порядок суффиксов не меняется?
-    //  1.2) почему ...
-    //  1.2) почему ...
-    //  1.2) почему ...
-    //  1.3) почему можно сортировать по первым ceil(log_2(n)) символам и всё ок?
-    //  2) сортировка по первому символа (2^k, k = 0),
-    //  3) сортировка 2^(k + 1), если отсортировано по 2^k:
-    //   3.1) сортировка по второй половине пары, почему действительно отсортровали.
-
-    // Для 1.3 что-то такое можно использовать.
-    // Сортируем зацикленные циклические сдвиги по первым 2^len_log символам.
-    // После сортировать нет смысла, т.к. результаты сравнений не поменяются,
-    //   потому что у всех зацикленных циклических суффиксов есть решетка,
-    //   у различных по длине она в разных местах, потому знак
-    //   неравенства становится гарантированно известен после просмотра
-    //   первых text.size() символов: обязательно встретим решетку, она
-    //   не совпадёт. Мб и раньше будет несовпадение.
-
-    assert(!text.empty());
-
-    // Этап 1: дополнение строки.
-    std::vector<uint16_t> text_mod;
-    text_mod.insert(text_mod.end(), text.begin(), text.end());
-    text_mod.push_back(255 + 1);
-
-    // Общие массивы для этапов, остаются с предыдущей итерации
-    //   для новой.
-    std::vector<size_t> sorted_items;
-    std::vector<size_t> component_by_item(text_mod.size(), 0);
-
-    // Этап 2.
-    // Сортируем по первому символу, это первые 2^k
-    //   символов для k = 0.
-    // Для сортировок подсчётом на следующих итерациях
-    //   надо знать алфавит, чтобы выделить массив.
-    //   Наш алфавит -- номера компонент эквивалентности.
-    //   На (k+1)-ой итерации мы сортируем по номерам с
-    //   предыдущей итерации: TODO: ПРОВЕРИТЬ, КОГДА НАПИШУ КОД.
-    //   Потому можно выделить массив на длину строки элементов,
-    //   т.к. номер компоненты начинается с нуля и их не больше,
-    //   чем суффиксов +1, это длина text_mod. Единственное, в
-    //   чем беда: при сортировке подсчётом по первому символу
-    //   номер компоненты равен номеру символа в алфавите.
-    //   Пересчитаем номер компоненты заново после сортировки, что там.
-    constexpr uint16_t kSrcStrAlphabetMaxChr = 255 + 1;
-    // Сортируем строки длины 1.
-    {
-        std::vector<size_t> num_occurs(static_cast<size_t>(kSrcStrAlphabetMaxChr) + 1, 0);
-        for (size_t i = 0; i < text_mod.size(); ++i) {
-            const size_t digit = text_mod[i];
-            num_occurs[digit] += 1;
-        }
-        // Исключающие префиксные суммы, как говорят публикации
-        //   алгоритма Каркайнена-Сандерса.
-        // Вообще, можно делать стабильную сортировку подсчётом
-        //  двумя способами: считать исключающие суммы,
-        //  количество элементов до компоненты, тогда перебирать
-        //  в прямом порядке отсоритрованный массив, в каждую
-        //  компоненту попадает наименьший. Или хранить включая,
-        //  тогда перебирать в обратном, в каждую компоненту
-        //  попадает наибольший, в конец компоненты.
-        std::vector<size_t>& num_items_before_digit = num_occurs;
-        size_t cur_digit_num_items_before = 0;
-        for (size_t i = 0; i <= kSrcStrAlphabetMaxChr; ++i) {
-            size_t num_occurences = num_occurs[i];
-            num_items_before_digit[i] = cur_digit_num_items_before;
-            // For the next iteration this pos is included.
-            cur_digit_num_items_before += num_occurences;
-        }
-        sorted_items.assign(text_mod.size(), 0);
-        for (size_t i = 0; i < text_mod.size(); ++i) {
-            const size_t digit = text_mod[i];
-            sorted_items[num_items_before_digit[digit]] = i;
-            num_items_before_digit[digit] += 1;
+// Список директорий, по одной на строку. Пустые строки
+//   пропускаются.
+bool read_dir_list(const fs::path& path, std::vector<std::string>& dirs) {
+    std::ifstream stream(path);
+    if (!stream) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
         }
-        // Считаем номера компонент эквивалентности.
-        component_by_item[sorted_items[0]] = 0;
-        for (size_t i = 1; i < sorted_items.size(); ++i) {
-            // Пока это ещё символы, можно смотреть в текст.
-            //   Дальше придется смотреть номера компонент
-            //   эквивалентности. И тогда понадобится новый
-            //   массив, чтобы не перезаписывать старые
-            //   значения.
-            // TODO: make this implementation detail, don't think about it.
-            // TODO: make a small version of this algo, on associative containers,
-            //   in python, so that it's small and concise, ready to be memorised.
-            if (text[sorted_items[i]] != text[sorted_items[i - 1]]) {
-                component_by_item[sorted_items[i]] = component_by_item[sorted_items[i - 1]] + 1;
-            } else {
-                component_by_item[sorted_items[i]] = component_by_item[sorted_items[i - 1]];
-            }
+        if (!line.empty()) {
+            dirs.push_back(line);
         }
     }
+    return !stream.bad();
+}
 
-    // TODO: write step text here. Read the original article, explain better.
-    // Для перехода к следующей итерации нам нужна дополнительная память:
-    //   новый порядок, потому что мы сортируем по второй половине
-    //   сдвигом, чтобы воспользоваться в стабильной сортировке подсчётом.
-    //   Но резуьтат сортировки подсчётом мы при этом процессе записываем
-    //   в старый;
-    //   и старые номера компонент по элементам, это наши цифры в сортироке
-    //   подсчётом, т.к. мы после сортировки должны получить новые номера
-    //   компонент по обоим парам, не только по первой, при этом мы
-    //   используем массив старых компонент, чтобы сравнивать.
-    // Мы не можем и проходится по старому, и писать туда новый порядок,
-    //   т.к. это перезатрёт позиции, в которые мы ещё не зашли.
-    // Если пишете какой-то алгоритм в первый раз, создавайте максимальное
-    //   количество массивов, для каждой величины по смыслу: новые величины
-    //   после итерации, старые до итерации и т.п. Потом в конце итерации
-    //   замените старые на новые.
-    std::vector<size_t> new_sorted_items(text_mod.size());
-    std::vector<size_t> new_component_by_item(text_mod.size());
-    // ull to avoid comparision between signed and unsigned, it's
-    //   a warning. Don't think about it when you write it first
-    //   time, you'll fix that.
-    //   TODO: сделать секцию: особенности реализации на C++, там это указать.
-    // While previous iteration was not enough.
-    // (1ull << (len_log - 1)) < text_mod.size() is wrong. What'll happen?
-    //   We need to sort by more than, length characters, This will stop
-    //   the first time it's greater than length, without sorting!
-    //   It may become greater, just only once! If it wasn't greater or
-    //   equal before.
-    for (size_t len_log = 1; (1ull << (len_log - 1)) < text_mod.size(); ++len_log) {
-        // Сортируем по второй половине, просто сдвинув
-        //   индексы: для каждой второй половины индекс
-        //   первой половины определяется однозначно, а
-        //   как отсортированы вторые половины знаем.
-        const size_t len = static_cast<size_t>(1) << len_log;
-        const size_t half_len = len / 2;
-        // Отсортированы суффиксы по первым 2^(k - 1) символам.
-        // Это вторые половины некоторых строк, т.к.
-        //   строки зациклены.
-        // Детально: просто возьмём любой суффикс, возьмём
-        //   вторую половину из первых 2^k символов. Это тоже
-        //   некоторый суффикс. И мы знаем порядок всех таких
-        //   суффиксов, если оставим их и отсортируем
-        //   (мультимножества строк совпадают).
-        // Переидем к первым половинам, вычтя половину длины,
-        //   получим упорядочивание строк длины 2^k по вторым
-        //   половинам. Т.е. мы знаем строку с минимальной
-        //   первой половиной, со второй по величине, если
-        //   просто произведем операции. Тогда просто к каждой
-        //   применим эту операцию и получим упорядочивание.
-        // TODO: найти это в оригинальной публикации, посмотреть, как там пишут, обсудить.
-        for (size_t i = 0; i < text_mod.size(); ++i) {
-            new_sorted_items[i] = (sorted_items[i] + text_mod.size() - half_len) % text_mod.size();
-        }
-        // Сортировка по второй половине закончена.
-
-        // Сортируем по первой половине (по компоненте первого элемента пары) подсчётом.
-        // Сдвигов n, потому компонент эквивалентности нужно не более, чем n.
-        // Чтобы сортировать устойчиво по второй половине, нам нужно проходить
-        //   по элементам в перевернутом отсортированном порядке.
-        //   Нам нужен отсортрованный порядок, потому будем его хранить.
-        // TODO: потом вынести, чтобы постоянно память не выделять.
-        //   Это в шаги по оптимизации написать. Код оставить, просто
-        //   закомментировать. Указать наверху, что оптимизация №2, на первом
-        //   написании пропустить. А здесь указать, первое написание, понятное.
-        // Типичная сортировка подсчётом, правда алфавит -- компоненты
-        //   эквивалентности с прошлого шага.
-        {
-            std::vector<size_t> num_occurs(text_mod.size(), 0);
-            for (size_t i = 0; i < text_mod.size(); ++i) {
-                const size_t digit = component_by_item[i];
-                num_occurs[digit] += 1;
+// Возвращает код выхода программы при ошибке и 0, если
+//   аргументы разобраны.
+int parse_options(int argc, char** argv, Options& options) {
+    std::vector<std::string_view> positional;
+    bool has_refs = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+        if (arg == "--ref") {
+            has_refs = true;
+            if (i + 1 == argc) {
+                return 1;
             }
-            // Исключающие префиксные суммы, как говорят публикации
-            //   алгоритма Каркайнена-Сандерса.
-            std::vector<size_t>& num_items_before_digit = num_occurs;
-            size_t cur_digit_num_items_before = 0;
-            for (size_t i = 0; i < num_occurs.size(); ++i) {
-                size_t num_occurences = num_occurs[i];
-                num_items_before_digit[i] = cur_digit_num_items_before;
-                // For the next iteration this pos is included.
-                cur_digit_num_items_before += num_occurences;
+            options.ref_dirs.emplace_back(argv[++i]);
+            if (options.ref_dirs.back().empty()) {
+                return 1;
             }
-            // Перебираем пары в порядке сортировки по второй половине.
-            for (size_t i: new_sorted_items) {
-                // Берем компоненту первой половины.
-                const size_t digit = component_by_item[i];
-                sorted_items[num_items_before_digit[digit]] = i;
-                num_items_before_digit[digit] += 1;
+        } else if (arg == "--ref-list") {
+            has_refs = true;
+            if (i + 1 == argc) {
+                return 1;
             }
-            // Считаем номера компонент эквивалентности.
-            new_component_by_item[sorted_items[0]] = 0;
-            for (size_t i = 1; i < sorted_items.size(); ++i) {
-                size_t prev_item = sorted_items[i - 1];
-                size_t cur_item = sorted_items[i];
-
-                size_t prev_item_first_half_comp  = component_by_item[prev_item];
-                size_t prev_item_second_half_comp = component_by_item[(prev_item + half_len) % text_mod.size()];
-
-                size_t cur_item_first_half_comp  = component_by_item[cur_item];
-                size_t cur_item_second_half_comp = component_by_item[(cur_item + half_len) % text_mod.size()];
-
-                // We already know (p_f, p_s) <= (c_f, c_s),
-                //   it's p_f < c_f || (p_f == c_f && p_s <= c_s)
-                // We just they are not equal we just need to
-                //   check p_f < c_f || p_s < c_s, because if
-                //   p_f < c_f is not true, p_f >= c_f,
-                //   then p_f == c_f.
-                if (prev_item_first_half_comp < cur_item_first_half_comp || prev_item_second_half_comp < cur_item_second_half_comp) {
-                    new_component_by_item[cur_item] = new_component_by_item[prev_item] + 1;
-                } else {
-                    new_component_by_item[cur_item] = new_component_by_item[prev_item];
-                }
+            std::string_view path(argv[++i]);
+            if (!read_dir_list(fs::path(path), options.ref_dirs)) {
+                std::cerr << "Failed to read the directory list " << path << '\n';
+                return 1;
+            }
+        } else if (arg == "--engine") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            std::string_view value(argv[++i]);
+            if (value == "sam") {
+                options.engine = Engine::kSuffixAutomaton;
+            } else if (value == "sa") {
+                options.engine = Engine::kSuffixArray;
+            } else {
+                return 1;
+            }
+        } else if (arg == "--metric") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            std::string_view value(argv[++i]);
+            if (value == "lcs") {
+                options.metric = Metric::kLongestCmnSubstr;
+            } else if (value == "chunks") {
+                options.metric = Metric::kSharedChunks;
+            } else {
+                return 1;
+            }
+        } else if (arg == "--threads") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            std::optional<size_t> value = parse_size(argv[++i]);
+            if (!value.has_value() || *value == 0) {
+                return 1;
+            }
+            options.num_threads = *value;
+        } else if (arg == "--max-memory") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            std::optional<size_t> value = parse_byte_size(argv[++i]);
+            if (!value.has_value()) {
+                return 1;
+            }
+            options.max_memory = *value;
+        } else if (arg == "--cache") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            options.cache_dir = argv[++i];
+            if (options.cache_dir.empty()) {
+                return 1;
+            }
+        } else if (arg == "--stats") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            options.stats_path = argv[++i];
+            if (options.stats_path.empty()) {
+                return 1;
             }
-            // Массив новых компонент переходит в следующую итерацию,
-            //   а предыдущий используем как временную память.
-            //   Мы её перезапишем.
-            // А массив отсортированного порядка мы поменяли ещё
-            //   при сортировке по первой половине.
-            std::swap(new_component_by_item, component_by_item);
+        } else if (arg == "--format") {
+            if (i + 1 == argc) {
+                return 1;
+            }
+            std::string_view value(argv[++i]);
+            if (value == "text") {
+                options.format = OutputFormat::kText;
+            } else if (value == "sections") {
+                options.format = OutputFormat::kSections;
+            } else if (value == "json") {
+                options.format = OutputFormat::kJson;
+            } else if (value == "csv") {
+                options.format = OutputFormat::kCsv;
+            } else {
+                return 1;
+            }
+        } else if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg.starts_with("--")) {
+            return 1;
+        } else {
+            positional.push_back(arg);
         }
     }
-    // После всех итераций отсортировали по большому количеству символов (>= n),
-    //   по факту получили сортировку суффиксов.
-    // Только удалим символ ноль, он лежит первым, т.к. это самый маленький
-    //   суффикс.
-    //   TODO: добавить в шаги, указать здесь шаг, как выше.
-    sorted_items.erase(sorted_items.begin(), sorted_items.begin() + 1);
-    suffix_array = std::move(sorted_items);
-    // После всех итераций размер каждой компоненты равен одному,
-    //   т.к. все элементы различны. И это просто индекс суффикса
-    //   в суффиксном массиве (обратный суффиксный массив).
-    //   TODO: добавить в шаги, указать здесь шаг, как выше.
-    //   TODO: указать, зачем обратный суффиксный массив и в шаге, и тут: для lcp.
-    // Только нужно удалить компоненту по item-у text.size(), т.к это нулевой символ.
-    //   И все компоненты сдвинуть на один, т.к. первая компонента -- компонента
-    //   нулевого символа.
-    component_by_item.erase(component_by_item.end() - 1, component_by_item.end());
-    for (size_t& component: component_by_item) {
-        component -= 1;
-    }
-    inv_suffix_array = std::move(component_by_item);
-}
-
-std::vector<size_t> calculate_lcp(const std::span<uint8_t> text, const std::vector<size_t>& suffix_array, const std::vector<size_t>& inv_suffix_array) {
-    assert(!text.empty());
-
-    // Алгоритм Аримуры-Арикавы-Касаи-Ли-Парка
-    //   построение массива lcp для суффиксного
-    //   массива.
-    // Пусть sa -- суффиксный массив,
-    //   isa    -- обратный суффиксный массив
-    //     (по номеру суффикса позиция в
-    //      суффиксном массиве),
-    //   text   -- текст.
-    // Основное утверждение:
-    //   lcp[isa[i + 1]] >= lcp[isa[i]] - 1.
-    //   Возьмём суффикс, у которого есть следующий в суффиксном массиве.
-    //   У него есть какой-то lcp с предыдущим суффиксом в суффиксном массиве.
-    //   Если lcp с предыдущим символом равен нулю, то получаем неравенство
-    //   lcp[*] >= -1, что всегда верно, ведь lcp не отрицателен.
-    //   Если lcp с предыдущим символом как минимум один, то удалим их общий
-    //   первый символ. Получим два суффикса, которые так же упорядочены:
-    //   предыдущий суффикс был меньше текущего, т.е. в первой несовпадающей
-    //   позиции он меньше, или совпадает во всех, но длина меньше (суффиксы
-    //   с разным началом никогда не равны, т.к. у них как минимум разные
-    //   длины, если даже все символы совпадают). Тогда после удаления
-    //   первого совпадающего символа сравнение такое же. Наидлиннейший
-    //   отрезок совпадающих первых символов сдвинулся на один символ, его
-    //   длина уменьшилась на один символ. Значит, lcp между этими двумя
-    //   отрезками ровно lcp[isa[i]] - 1. Но они могли быть не соседними:
-    //   просто предположим, что не соседние, тогда допишем символ, к этим
-    //   двум суффиксам можем дописать, а возможно, что к суффиксу между
-    //   ними не можем дописать этот символ, там другой. Не смогли доказать,
-    //   и реально такой пример может быть. Потому просто есть неравенство,
-    //   что сколько-то длины lcp у нас уже есть.
-    // Лучше объяснено тут: https://www.youtube.com/watch?v=s68lnO3yEKY&list=PLtb_PNVHdsV7QlpdH1XmsqqF9AxYRQpWY&index=19
-    // А теперь как сделать алгоритм? Будем двигаться от самых длинных
-    //   суффиксов к коротким (т.е. просто от начала строки к концу,
-    //   перебирать начало суффикса в строке). Для коротких у нас уже
-    //   будет неравенство от их продолжений, что сколько-то lcp у них
-    //   есть, это похоже на z-функцию. Можно попробовать увеличить.
-    //   Переход к следующему суффиксу и есть удаление первого символа,
-    //   потому lcp -- просто переменная между итерациями.
-    // За сколько это работает? Каждую итерацию убывает на один,
-    //   увеличивается на много, но сама величина 0 <= lcp <= |t|.
-    // Амортизационный анализ. Итерации связаны с изменением некоторой
-    //   величины, на которую есть оценка. Пусть n_i -- количество
-    //   итераций while с попыткой увеличить lcp.
-    //   TODO: написать, мб к экзамену. Кажется, сейчас уже нет смысла,
-    //   стало понятно. n_i = lcp_i - lcp_{i - 1}...
-    //   sum (C1 + C2 n_i) <= C_1 * n + C_2 * (lcp_{n} - lcp_0) <= C n
-    // Только тут ещё есть проблема, как мы обходим случай, когда
-    //   встречаем суффикс, который первый в суффиксном массиве? Тогда
-    //   либо на предыдущей итерации был lcp = 0, тогда мы просто
-    //   наивно посчитаем, всё ок так же по амортизированному анализу.
-    //   Либо предыдущий в СА суффикс на предыдущей итерации был из
-    //   одного символа. Иначе lcp > 0, у нас был предыдущий суффикс
-    //   в СА, а после удаления символа нет, тогда получился пустой
-    //   суффикс просто там, если там длина хотя бы два, то суффикс
-    //   меньше будет. lcp = 1 на прошлой итерации, на этой оценка
-    //   снизу ноль. Посчитаем явно на следующей, всё ок.
-
-    std::vector<size_t> result(text.size() - 1, 0);
-    size_t lcp_lower_bound = 0;
-    for (size_t i = 0; i < text.size(); ++i) {
-        size_t sa_pos = inv_suffix_array[i];
-        if (sa_pos == 0) {
-            continue;
-        }
 
-        size_t sa_prev_suffix = suffix_array[sa_pos - 1];
+    // С --ref и --ref-list вторая директория не нужна: после
+    //   первой может идти только процент.
+    if (has_refs && options.ref_dirs.empty()) {
+        return 1;
+    }
+    const size_t num_dirs = has_refs ? 1 : 2;
+    if (positional.size() != num_dirs && positional.size() != num_dirs + 1) {
+        return 1;
+    }
+    options.dir1 = positional[0];
+    if (num_dirs == 2) {
+        options.ref_dirs.emplace_back(positional[1]);
+    }
 
-        size_t lcp = lcp_lower_bound;
-        size_t cur_suffix_len = text.size() - i;
-        size_t sa_prev_suffix_len = text.size() - sa_prev_suffix;
-        while (lcp < cur_suffix_len && lcp < sa_prev_suffix_len && text[sa_prev_suffix + lcp] == text[i + lcp]) {
-            lcp += 1;
+    if (positional.size() == num_dirs + 1) {
+        auto percent_sv = positional[num_dirs];
+        for (char chr: percent_sv) {
+            if (chr < '0' || chr > '9') {
+                return 2;
+            }
         }
-
-        // В массиве lcp индекс -- индекс суффикса в суффиксном массиве,
-        //   значение -- длина наидлиннейшего общий префикса со
-        //   следующим, а мы для каждой пары соседних в суффиксном
-        //   массиве перебирали второго из пары, потому надо уменьшить.
-        // То же самое получается, если в lcp хранить длину наидлиннейшего
-        //   общий префикса с предыдущим.
-        result[sa_pos - 1] = lcp;
-
-        // Без нижней оценки на lcp, т.е. без того утверждения (леммы Касаи)
-        //   если выполнять, количество итераций while наверху не соответстует
-        //   изменению lcp, поскольку мы заново начинаем с 0, а с оценкой снизу
-        //   начинаем с почти предыдущего значения.
-        if (lcp == 0) {
-            lcp_lower_bound = 0;
-        } else {
-            lcp_lower_bound = lcp - 1;
+        // TODO: check value didn't overflow, fits into int.
+        size_t num_chrs_processed = 0;
+        options.percent_for_not_eq = std::stoi(std::string(percent_sv), &num_chrs_processed);
+        if (num_chrs_processed != percent_sv.size() || options.percent_for_not_eq < 0 || options.percent_for_not_eq > 100) {
+            std::cout << "Invalid percentage value." << '\n';
         }
     }
 
-    return result;
+    return 0;
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& stream, const std::span<T>& span) {
-    std::cout << '{';
-    for (auto& item: span) {
-        std::cout << item;
-        std::cout << ',';
-    }
-    std::cout << '}';
-    return stream;
+// Порядок обхода директории зависит от файловой системы,
+//   а отчёт должен быть одинаковым от запуска к запуску.
+void sort_by_name(const Corpus& corpus, std::vector<size_t>& items) {
+    std::sort(items.begin(), items.end(), [&](size_t lhs, size_t rhs) {
+        return corpus.file(lhs).path.filename() < corpus.file(rhs).path.filename();
+    });
 }
 
-template<typename T>
-std::ostream& operator<<(std::ostream& stream, const std::vector<T>& vector) {
-    stream << std::span(vector.begin(), vector.end());
-    return stream;
+// С бюджетом памяти большие файлы не копируются в буфер корпуса
+//   и остаются без отпечатков: и буфер, и отпечаток занимают
+//   память порядка размера файла. Большой -- от восьмой части
+//   бюджета.
+size_t large_file_size(const Options& options) {
+    return options.max_memory == 0 ? SIZE_MAX : options.max_memory / 8;
 }
 
-size_t get_longest_cmn_substr_len(const std::span<uint8_t>& first, const std::span<uint8_t>& second) {
-    std::vector<uint8_t> joined_vector;
-    joined_vector.insert(joined_vector.end(), first.begin(), first.end());
-    joined_vector.insert(joined_vector.end(), second.begin(), second.end());
-
-    // std::cout << "joined_vector = " << joined_vector << '\n';
-
-    std::vector<size_t> suffix_array;
-    std::vector<size_t> inv_suffix_array;
-    get_suffix_array(joined_vector, suffix_array, inv_suffix_array);
-    std::vector<size_t> lcp = calculate_lcp(joined_vector, suffix_array, inv_suffix_array);
-
-    // TODO: Проверить, что в начале нет пустого суффиекса.
+// Хеши содержимого нужны, чтобы найти одинаковые файлы, а
+//   отпечатки -- чтобы отсечь непохожие пары. Для файлов, что
+//   не поменялись с прошлого запуска, берём их из кеша и сами
+//   файлы пока не читаем; остальные читаем и считаем заново.
+void fingerprint_files(Corpus& corpus, std::span<const size_t> ids, std::vector<Sketch>& sketches, FingerprintCache* cache, const Options& options) {
+    std::vector<size_t> fingerprinted_items;
+    std::vector<std::optional<FileStamp>> stamps(corpus.size());
+    for (size_t id: ids) {
+        if (cache != nullptr) {
+            const fs::path& path = corpus.file(id).path;
+            stamps[id] = stat_file(path);
+            ContentHash hash;
+            if (stamps[id].has_value() && stamps[id]->size < large_file_size(options) && cache->lookup(path, *stamps[id], hash, sketches[id])) {
+                corpus.set_fingerprint(id, static_cast<size_t>(stamps[id]->size), hash);
+                continue;
+            }
+        }
+        fingerprinted_items.push_back(id);
+    }
 
-    // Суффиксы совпадающих подстрок наибольшей длины находятся рядом в суффиксном массиве.
-    size_t result = 0;
-    for (size_t i = 1; i < suffix_array.size(); ++i) {
-        bool prev_is_from_first = suffix_array[i - 1] < first.size();
-        bool cur_is_from_first  = suffix_array[i] < first.size();
-        if (prev_is_from_first != cur_is_from_first) {
-            result = std::max(result, lcp[i - 1]);
+    // Отпечаток файла считается, пока читаются следующие, поэтому
+    //   этап kSketch пересекается с kIngest.
+    PhaseTimer sketch_timer(Phase::kSketch);
+    corpus.load(fingerprinted_items, [&](size_t id) {
+        if (corpus.file(id).size < large_file_size(options)) {
+            sketches[id] = compute_sketch(corpus.content(id));
         }
+    }, options.num_threads);
+    for (size_t id: fingerprinted_items) {
+        sketch_timer.add_bytes(corpus.file(id).size);
     }
+    sketch_timer.stop();
+
+    if (cache != nullptr) {
+        for (size_t id: fingerprinted_items) {
+            // Файл поменялся между stat и чтением: такой хеш
+            //   не соответствует FileStamp, не запоминаем.
+            //   Файл без отпечатка тоже: пустой отпечаток из кеша
+            //   отсёк бы его пары.
+            if (stamps[id].has_value() && stamps[id]->size == corpus.file(id).size && corpus.file(id).size < large_file_size(options)) {
+                cache->store(corpus.file(id).path, *stamps[id], corpus.file(id).hash, sketches[id]);
+            }
+        }
+        if (!cache->save()) {
+            std::cerr << "Failed to write the fingerprint cache to " << options.cache_dir << '\n';
+        }
+    }
+}
 
-    return result;
+// Куски для меры kSharedChunks. Считаются по содержимому,
+//   поэтому файлы, отпечатки которых взяты из кеша, дочитываются.
+void chunk_files(Corpus& corpus, std::span<const size_t> ids, std::vector<ChunkSet>& chunk_sets, const Options& options) {
+    PhaseTimer chunk_timer(Phase::kChunk);
+    corpus.load(ids, [&](size_t id) {
+        chunk_sets[id] = compute_chunks(corpus.content(id));
+    }, options.num_threads);
+    for (size_t id: ids) {
+        chunk_timer.add_bytes(corpus.file(id).size);
+    }
+    chunk_timer.stop();
+    Stats& stats = Stats::global();
+    for (size_t id: ids) {
+        for (const ChunkEntry& chunk: chunk_sets[id]) {
+            stats.add(Counter::kChunks, chunk.count);
+        }
+    }
 }
 
 int main(int argc, char** argv) {
-    if (argc != 3 && argc != 4) {
-		return 1;
-	}
+    Options options;
+    if (int error = parse_options(argc, argv, options); error != 0) {
+        print_usage(argv[0]);
+        return error;
+    }
+    if (!options.stats_path.empty()) {
+        Stats::global().enable();
+    }
 
 	// В ответе требуется предоставить
 	//   результаты для каждой пары файлов
@@ -491,97 +347,232 @@ int main(int argc, char** argv) {
     //   C не более 8 + 8 + 8 + 2 байт. При сравнений файлов в 10
     //   мегабайт, потребуется 520 мегабайт. Можем себе позволить.
 
-	std::string_view dir1(argv[1]);
-    std::string_view dir2(argv[2]);
+    // Для файла второй директории можно построить суффиксный
+    //   автомат один раз (O(m_j)) и пройти по нему каждым файлом
+    //   первой за O(n_i). Тогда всего O(n * sum m_j + m * sum n_i),
+    //   повторных построений для пар нет. Памяти автомат требует
+    //   не больше 2 * 12 + 3 * 12 байт на символ, только для
+    //   одного файла.
+
+    // dirs[0] -- первая директория, остальные -- те, с которыми
+    //   она сравнивается. Со многими директориями сравнение одно:
+    //   все их файлы -- столбцы одной матрицы пар. Файл читается и
+    //   индексируется один раз, а одинаковое содержимое в разных
+    //   директориях (соседние снимки одного набора) сравнивается
+    //   один раз на класс. В отчёте "вторая директория" -- все они.
+    std::vector<std::string> dirs{std::string(options.dir1)};
+    dirs.insert(dirs.end(), options.ref_dirs.begin(), options.ref_dirs.end());
+
+    // Каждый файл читаем с диска один раз, дальше работаем
+    //   с его содержимым в памяти.
+    Corpus corpus;
+    corpus.set_map_min_size(large_file_size(options));
+    std::vector<std::vector<size_t>> items_by_dir(dirs.size());
+    for (size_t dir = 0; dir < dirs.size(); ++dir) {
+        for (const auto& item: fs::directory_iterator(dirs[dir])) {
+            items_by_dir[dir].push_back(corpus.add_file(item.path()));
+        }
+        sort_by_name(corpus, items_by_dir[dir]);
+    }
+    std::vector<size_t>& dir1_items = items_by_dir[0];
+    // Файлы остальных директорий подряд, в порядке директорий.
+    std::vector<size_t> dir2_items;
+    auto join_dir2_items = [&] {
+        dir2_items.clear();
+        for (size_t dir = 1; dir < dirs.size(); ++dir) {
+            dir2_items.insert(dir2_items.end(), items_by_dir[dir].begin(), items_by_dir[dir].end());
+        }
+    };
+    join_dir2_items();
+
+    // Имена файлов в отчёте по номерам в корпусе. Собираем один
+    //   раз; в режиме наблюдения имена новых номеров дописываются,
+    //   старые остаются, пока на них ссылается прошлый отчёт.
+    std::vector<std::string> names;
+    auto add_names = [&](std::string_view dir, std::span<const size_t> ids) {
+        for (size_t id: ids) {
+            names.resize(std::max(names.size(), id + 1));
+            names[id] = std::string(dir) + "/" + corpus.file(id).path.filename().string();
+        }
+    };
+    for (size_t dir = 0; dir < dirs.size(); ++dir) {
+        add_names(dirs[dir], items_by_dir[dir]);
+    }
 
-    int percent_for_not_eq = 100;
-    if (argc == 4) {
-        auto percent_sv = std::string_view(argv[3]);
-        for (char chr: percent_sv) {
-            if (chr < '0' || chr > '9') {
-                return 2;
-            }
+    std::optional<FingerprintCache> cache;
+    if (!options.cache_dir.empty()) {
+        cache.emplace(fs::path(options.cache_dir));
+    }
+    std::vector<Sketch> sketches(corpus.size());
+    std::vector<size_t> all_items(corpus.size());
+    for (size_t id = 0; id < corpus.size(); ++id) {
+        all_items[id] = id;
+    }
+    fingerprint_files(corpus, all_items, sketches, cache ? &*cache : nullptr, options);
+    std::vector<ChunkSet> chunk_sets(corpus.size());
+    if (options.metric == Metric::kSharedChunks) {
+        chunk_files(corpus, all_items, chunk_sets, options);
+    }
+
+    ComparisonOptions comparison_options{options.percent_for_not_eq, options.engine, options.metric, options.num_threads};
+    comparison_options.max_memory = options.max_memory;
+    // Отчёт kText печатает каждую пару и процент у пар ниже порога,
+    //   а отсечения до порога его не дают: сравниваем все пары.
+    if (options.format == OutputFormat::kText) {
+        comparison_options.percent_for_not_eq = 0;
+    }
+    // Файлы от large_file_size без отпечатков.
+    comparison_options.max_sketched_size = large_file_size(options) - 1;
+    auto compare = [&](std::span<const size_t> rows, std::span<const size_t> cols) {
+        if (options.metric == Metric::kSharedChunks) {
+            return compare_files_by_chunks(corpus, chunk_sets, rows, cols, comparison_options);
         }
-        // TODO: check value didn't overflow, fits into int.
-        size_t num_chrs_processed = 0;
-        percent_for_not_eq = std::stoi(std::string(percent_sv), &num_chrs_processed);
-        if (num_chrs_processed != percent_sv.size() || percent_for_not_eq < 0 || percent_for_not_eq > 100) {
-            std::cout << "Invalid percentage value." << '\n';
+        return compare_files(corpus, sketches, rows, cols, comparison_options);
+    };
+    std::vector<PairMatch> matches = compare(dir1_items, dir2_items);
+    // Вывод -- после сравнения всех пар, рабочие потоки в поток
+    //   не пишут и друг друга на нём не ждут.
+    Report report;
+    {
+        PhaseTimer output_timer(Phase::kOutput);
+        report = make_report(dir1_items, dir2_items, matches, options.percent_for_not_eq);
+        write_report(std::cout, options.format, report, names);
+    }
+    if (!options.stats_path.empty()) {
+        // В режиме наблюдения -- замеры первого прохода.
+        std::ofstream stats_stream{std::string(options.stats_path)};
+        Stats::global().write_json(stats_stream);
+        if (!stats_stream) {
+            std::cerr << "Failed to write stats to " << options.stats_path << '\n';
         }
     }
+    if (!options.watch) {
+        return 0;
+    }
 
+    // Режим наблюдения. Корпус, хеши и отпечатки остаются в памяти;
+    //   когда файл меняется, пересчитываем только его строку или
+    //   столбец матрицы пар и печатаем разницу отчётов. Результаты
+    //   храним по номерам файлов в корпусе: у изменённого файла
+    //   номер новый, остальные пары не трогаются.
+    std::map<std::pair<size_t, size_t>, PairMatch> matches_by_ids;
+    for (const PairMatch& match: matches) {
+        matches_by_ids[{dir1_items[match.row], dir2_items[match.col]}] = match;
+    }
 
-    std::unordered_set<std::string> dir1_items_not_in_dir2;
-    std::unordered_set<std::string> dir2_items_in_dir1;
+    const std::vector<fs::path> dir_paths(dirs.begin(), dirs.end());
+    std::optional<DirectoryWatcher> watcher;
+    try {
+        watcher.emplace(dir_paths);
+    } catch (const std::system_error& error) {
+        std::cerr << "Failed to watch directories: " << error.what() << '\n';
+        return 3;
+    }
 
-	for (const auto& item_dir1: fs::directory_iterator(dir1)) {
-        std::vector<uint8_t> item_dir1_content;
-        {
-            std::ifstream stream(item_dir1.path());
-            uint8_t byte = 0;
-            while (true) {
-                * reinterpret_cast<char*>(&byte) = stream.get();
-                if (stream.fail()) {
-                    break;
+    for (;;) {
+        WatchEvents events = watcher->wait();
+
+        std::vector<std::set<std::string>> changed(dirs.size());
+        for (const FileChange& change: events.changes) {
+            changed[change.dir].insert(change.name);
+        }
+        if (events.overflowed) {
+            // Часть событий потеряна: перечитываем всё.
+            for (size_t dir = 0; dir < dirs.size(); ++dir) {
+                for (size_t id: items_by_dir[dir]) {
+                    changed[dir].insert(corpus.file(id).path.filename().string());
+                }
+                std::error_code error;
+                for (const auto& item: fs::directory_iterator(dir_paths[dir], error)) {
+                    changed[dir].insert(item.path().filename().string());
                 }
-                item_dir1_content.push_back(byte);
             }
         }
 
-        size_t item_dir1_size = reinterpret_cast<size_t>(item_dir1.file_size());
-        bool found_in_dir2 = false;
-		for (const auto& item_dir2: fs::directory_iterator(dir2)) {
-            std::vector<uint8_t> item_dir2_content;
-            {
-                std::ifstream stream(item_dir2.path());
-                uint8_t byte = 0;
-                while (true) {
-                    * reinterpret_cast<char*>(&byte) = stream.get();
-                    if (stream.fail()) {
-                        break;
-                    }
-                    item_dir2_content.push_back(byte);
+        // Старую версию файла убираем, новую добавляем с новым номером.
+        std::vector<std::vector<size_t>> new_items(dirs.size());
+        for (size_t dir = 0; dir < dirs.size(); ++dir) {
+            std::vector<size_t>& items = items_by_dir[dir];
+            for (const std::string& name: changed[dir]) {
+                auto it = std::find_if(items.begin(), items.end(), [&](size_t id) {
+                    return corpus.file(id).path.filename() == name;
+                });
+                if (it != items.end()) {
+                    const size_t id = *it;
+                    items.erase(it);
+                    corpus.remove_file(id);
+                    sketches[id] = Sketch();
+                    chunk_sets[id] = ChunkSet();
+                    std::erase_if(matches_by_ids, [&](const auto& entry) {
+                        return entry.first.first == id || entry.first.second == id;
+                    });
                 }
-            }
 
-            size_t cmn_substr_size = get_longest_cmn_substr_len(item_dir1_content, item_dir2_content);
-
-            size_t max_size = std::max(item_dir1_content.size(), item_dir2_content.size());
-            // std::cout << "cmn_substr_size = " << cmn_substr_size << std::endl;
-            std::cout << dir1 << "/" << item_dir1.path().filename().string() << " - " << dir2 << "/" << item_dir2.path().filename().string();
-            // cmn_substr_size * 100 / max_len < percent_for_not_eq
-            //  Если процент больше, то файлы считаются одинаковыми.
-            //  Избегаем округлений, работая с целыми числами.
-            if (cmn_substr_size * 100 >= max_size * percent_for_not_eq) {
-                std::cout << '\n';
-                dir2_items_in_dir1.insert(fs::absolute(item_dir2.path()).string());
-                found_in_dir2 = true;
-            } else {
-                std::cout << " - " << std::fixed << std::setw(0) << (cmn_substr_size * 100 / max_size) << '\n';
+                fs::path path = dir_paths[dir] / name;
+                std::error_code error;
+                if (fs::exists(path, error)) {
+                    const size_t id = corpus.add_file(path);
+                    sketches.resize(corpus.size());
+                    chunk_sets.resize(corpus.size());
+                    items.push_back(id);
+                    new_items[dir].push_back(id);
+                }
             }
-
-            // The process may take long, show the user that there is
-            //   some progress.
-            std::cout.flush();
-		}
-        if (!found_in_dir2) {
-            dir1_items_not_in_dir2.insert(fs::absolute(item_dir1.path()).string());
+            sort_by_name(corpus, items);
         }
-	}
 
-    for (const auto& item_dir1: dir1_items_not_in_dir2) {
-        std::cout << dir1 << '/' << fs::path(item_dir1).filename().string() << ";";
-    }
-    std::cout << '\n';
+        join_dir2_items();
+        // Новые файлы всех директорий, кроме первой.
+        std::vector<size_t> new_dir2_items;
+        for (size_t dir = 1; dir < dirs.size(); ++dir) {
+            new_dir2_items.insert(new_dir2_items.end(), new_items[dir].begin(), new_items[dir].end());
+        }
+        std::vector<size_t> changed_items = new_items[0];
+        changed_items.insert(changed_items.end(), new_dir2_items.begin(), new_dir2_items.end());
+        for (size_t dir = 0; dir < dirs.size(); ++dir) {
+            add_names(dirs[dir], new_items[dir]);
+        }
+        fingerprint_files(corpus, changed_items, sketches, cache ? &*cache : nullptr, options);
+        if (options.metric == Metric::kSharedChunks) {
+            chunk_files(corpus, changed_items, chunk_sets, options);
+        }
 
-    for (const auto& item_dir2: fs::directory_iterator(dir2)) {
-        auto abs_path = fs::absolute(item_dir2).string();
-        if (dir2_items_in_dir1.count(abs_path) > 0) {
-            continue;
+        // Новые файлы первой директории -- со всеми второй, остальные
+        //   файлы первой -- с новыми второй. Каждая пара один раз.
+        std::vector<size_t> old_dir1_items;
+        for (size_t id: dir1_items) {
+            if (std::find(new_items[0].begin(), new_items[0].end(), id) == new_items[0].end()) {
+                old_dir1_items.push_back(id);
+            }
         }
-        std::cout << dir2 << '/' << item_dir2.path().filename().string() << ";";
-    }
-    std::cout << '\n';
+        auto add_matches = [&](std::span<const size_t> rows, std::span<const size_t> cols) {
+            for (const PairMatch& match: compare(rows, cols)) {
+                matches_by_ids[{rows[match.row], cols[match.col]}] = match;
+            }
+        };
+        add_matches(new_items[0], dir2_items);
+        add_matches(old_dir1_items, new_dir2_items);
+
+        // Позиции в отчёте поменялись вместе со списками файлов.
+        std::unordered_map<size_t, size_t> positions;
+        for (size_t i = 0; i < dir1_items.size(); ++i) {
+            positions[dir1_items[i]] = i;
+        }
+        for (size_t j = 0; j < dir2_items.size(); ++j) {
+            positions[dir2_items[j]] = j;
+        }
+        matches.clear();
+        for (auto [ids, match]: matches_by_ids) {
+            match.row = positions[ids.first];
+            match.col = positions[ids.second];
+            matches.push_back(match);
+        }
+        std::sort(matches.begin(), matches.end(), [](const PairMatch& lhs, const PairMatch& rhs) {
+            return std::pair(lhs.row, lhs.col) < std::pair(rhs.row, rhs.col);
+        });
 
-    return 0;
+        Report new_report = make_report(dir1_items, dir2_items, matches, options.percent_for_not_eq);
+        write_report_diff(std::cout, options.format, report, new_report, names);
+        report = std::move(new_report);
+    }
 }
@@ -0,0 +1,55 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+size_t default_num_threads() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void parallel_for(size_t num_jobs, size_t num_threads, const std::function<void(size_t, size_t)>& job) {
+    num_threads = std::clamp<size_t>(num_threads, 1, std::max<size_t>(num_jobs, 1));
+
+    std::atomic<size_t> next_job = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&](size_t worker_index) {
+        while (true) {
+            size_t job_index = next_job.fetch_add(1, std::memory_order_relaxed);
+            if (job_index >= num_jobs) {
+                return;
+            }
+            try {
+                job(job_index, worker_index);
+            } catch (...) {
+                std::lock_guard guard(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_job.store(num_jobs, std::memory_order_relaxed);
+                return;
+            }
+        }
+    };
+
+    // Текущий поток тоже работает, чтобы при одном потоке
+    //   не создавать лишних.
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
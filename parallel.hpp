@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Количество потоков по умолчанию: по одному на ядро.
+size_t default_num_threads();
+
+// Выполняет job(job_index, worker_index) для каждого job_index
+//   из [0, num_jobs) на num_threads потоках. Задания раздаются
+//   по одному из общего счётчика: освободившийся поток берёт
+//   следующее, потому долгие задания не задерживают остальные.
+//   worker_index из [0, num_threads) позволяет заданиям брать
+//   память, выделенную на поток.
+// Если задание бросило исключение, остальные задания не
+//   начинаются, а исключение пробрасывается после завершения
+//   всех потоков.
+void parallel_for(size_t num_jobs, size_t num_threads, const std::function<void(size_t, size_t)>& job);
@@ -0,0 +1,325 @@
+#include "report.hpp"
+
+#include <algorithm>
+#include <set>
+#include <tuple>
+
+namespace {
+    // Вывод копится в строке и уходит в поток кусками: на
+    //   отчёт из тысяч строк несколько вызовов записи, а не по
+    //   вызову на строку.
+    constexpr size_t kFlushSize = 1 << 20;
+
+    class OutputBuffer {
+    public:
+        explicit OutputBuffer(std::ostream& stream): stream_(stream) {
+            buffer_.reserve(kFlushSize + 4096);
+        }
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        ~OutputBuffer() {
+            flush();
+            stream_.flush();
+        }
+
+        OutputBuffer& operator<<(std::string_view text) {
+            buffer_.append(text);
+            if (buffer_.size() >= kFlushSize) {
+                flush();
+            }
+            return *this;
+        }
+
+        OutputBuffer& operator<<(char chr) {
+            return *this << std::string_view(&chr, 1);
+        }
+
+        OutputBuffer& operator<<(size_t value) {
+            return *this << std::string_view(std::to_string(value));
+        }
+
+    private:
+        void flush() {
+            stream_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+
+        std::ostream& stream_;
+        std::string buffer_;
+    };
+
+    std::string_view kind_name(EntryKind kind) {
+        switch (kind) {
+        case EntryKind::kIdentical:
+            return "identical";
+        case EntryKind::kSimilar:
+            return "similar";
+        case EntryKind::kDifferent:
+            return "different";
+        case EntryKind::kOnlyInDir1:
+            return "only_in_dir1";
+        case EntryKind::kOnlyInDir2:
+            return "only_in_dir2";
+        }
+        return "";
+    }
+
+    bool is_pair(EntryKind kind) {
+        return kind == EntryKind::kIdentical || kind == EntryKind::kSimilar || kind == EntryKind::kDifferent;
+    }
+
+    // Поле CSV по RFC 4180: в кавычках, если есть разделитель,
+    //   кавычка или перевод строки; кавычки удваиваются.
+    void write_csv_field(OutputBuffer& out, std::string_view field) {
+        if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out << field;
+            return;
+        }
+        out << '"';
+        for (char chr: field) {
+            if (chr == '"') {
+                out << '"';
+            }
+            out << chr;
+        }
+        out << '"';
+    }
+
+    // Имена файлов -- произвольные байты; всё, что не печатается,
+    //   экранируется, остальное выводится как есть.
+    void write_json_string(OutputBuffer& out, std::string_view text) {
+        static constexpr char kHex[] = "0123456789abcdef";
+        out << '"';
+        for (char chr: text) {
+            const unsigned char byte = static_cast<unsigned char>(chr);
+            if (chr == '"' || chr == '\\') {
+                out << '\\' << chr;
+            } else if (byte < 0x20) {
+                out << "\\u00" << kHex[byte >> 4] << kHex[byte & 15];
+            } else {
+                out << chr;
+            }
+        }
+        out << '"';
+    }
+
+    void write_csv_entry(OutputBuffer& out, const ReportEntry& entry, std::span<const std::string> names) {
+        out << kind_name(entry.kind) << ',';
+        if (entry.kind == EntryKind::kOnlyInDir2) {
+            out << ',';
+            write_csv_field(out, names[entry.file1]);
+            out << ',';
+        } else {
+            write_csv_field(out, names[entry.file1]);
+            out << ',';
+            if (is_pair(entry.kind)) {
+                write_csv_field(out, names[entry.file2]);
+            }
+            out << ',';
+        }
+        if (is_pair(entry.kind)) {
+            out << entry.percent;
+        }
+        out << '\n';
+    }
+
+    // Поля записи без фигурных скобок.
+    void write_json_fields(OutputBuffer& out, const ReportEntry& entry, std::span<const std::string> names) {
+        if (is_pair(entry.kind)) {
+            out << "\"file1\": ";
+            write_json_string(out, names[entry.file1]);
+            out << ", \"file2\": ";
+            write_json_string(out, names[entry.file2]);
+            out << ", \"percent\": " << entry.percent;
+        } else {
+            out << "\"file\": ";
+            write_json_string(out, names[entry.file1]);
+        }
+    }
+
+    // В kText процент у пар ниже порога, в kSections -- у похожих.
+    void write_text_pair(OutputBuffer& out, OutputFormat format, const ReportEntry& entry, std::span<const std::string> names) {
+        out << names[entry.file1] << " - " << names[entry.file2];
+        const EntryKind kind_with_percent = format == OutputFormat::kSections ? EntryKind::kSimilar : EntryKind::kDifferent;
+        if (entry.kind == kind_with_percent) {
+            out << " - " << entry.percent;
+        }
+    }
+
+    void write_unmatched(OutputBuffer& out, const Report& report, std::span<const std::string> names) {
+        for (EntryKind kind: {EntryKind::kOnlyInDir1, EntryKind::kOnlyInDir2}) {
+            for (const ReportEntry& entry: report) {
+                if (entry.kind == kind) {
+                    out << names[entry.file1] << ';';
+                }
+            }
+            out << '\n';
+        }
+    }
+
+    void write_text(OutputBuffer& out, const Report& report, std::span<const std::string> names) {
+        for (const ReportEntry& entry: report) {
+            if (is_pair(entry.kind)) {
+                write_text_pair(out, OutputFormat::kText, entry, names);
+                out << '\n';
+            }
+        }
+        write_unmatched(out, report, names);
+    }
+
+    void write_sections(OutputBuffer& out, const Report& report, std::span<const std::string> names) {
+        for (EntryKind kind: {EntryKind::kIdentical, EntryKind::kSimilar}) {
+            for (const ReportEntry& entry: report) {
+                if (entry.kind == kind) {
+                    write_text_pair(out, OutputFormat::kSections, entry, names);
+                    out << '\n';
+                }
+            }
+        }
+        write_unmatched(out, report, names);
+    }
+
+    // CSV и JSON группируют записи по виду.
+    constexpr EntryKind kEntryKinds[] = {EntryKind::kIdentical, EntryKind::kSimilar, EntryKind::kDifferent, EntryKind::kOnlyInDir1, EntryKind::kOnlyInDir2};
+
+    void write_csv(OutputBuffer& out, const Report& report, std::span<const std::string> names) {
+        out << "kind,file1,file2,percent\n";
+        for (EntryKind kind: kEntryKinds) {
+            for (const ReportEntry& entry: report) {
+                if (entry.kind == kind) {
+                    write_csv_entry(out, entry, names);
+                }
+            }
+        }
+    }
+
+    void write_json(OutputBuffer& out, const Report& report, std::span<const std::string> names) {
+        out << '{';
+        for (EntryKind kind: kEntryKinds) {
+            // Массив пар ниже порога -- только когда они есть, у
+            //   остальных видов массив есть всегда.
+            if (kind == EntryKind::kDifferent && std::none_of(report.begin(), report.end(), [](const ReportEntry& entry) {
+                    return entry.kind == EntryKind::kDifferent;
+                })) {
+                continue;
+            }
+            out << (kind == EntryKind::kIdentical ? "\n  \"" : ",\n  \"") << kind_name(kind) << "\": [";
+            bool first = true;
+            for (const ReportEntry& entry: report) {
+                if (entry.kind != kind) {
+                    continue;
+                }
+                out << (first ? "\n    {" : ",\n    {");
+                write_json_fields(out, entry, names);
+                out << '}';
+                first = false;
+            }
+            out << (first ? "]" : "\n  ]");
+        }
+        out << "\n}\n";
+    }
+
+    using EntryKey = std::tuple<EntryKind, std::string_view, std::string_view, size_t>;
+
+    EntryKey entry_key(const ReportEntry& entry, std::span<const std::string> names) {
+        std::string_view file2 = is_pair(entry.kind) ? std::string_view(names[entry.file2]) : std::string_view();
+        return EntryKey(entry.kind, names[entry.file1], file2, entry.percent);
+    }
+
+    void write_change(OutputBuffer& out, OutputFormat format, std::string_view change, const ReportEntry& entry, std::span<const std::string> names) {
+        switch (format) {
+        case OutputFormat::kText:
+        case OutputFormat::kSections:
+            out << (change == "added" ? "+ " : "- ");
+            if (is_pair(entry.kind)) {
+                write_text_pair(out, format, entry, names);
+            } else {
+                out << names[entry.file1] << ';';
+            }
+            out << '\n';
+            break;
+        case OutputFormat::kCsv:
+            out << change << ',';
+            write_csv_entry(out, entry, names);
+            break;
+        case OutputFormat::kJson:
+            out << "{\"change\": \"" << change << "\", \"kind\": \"" << kind_name(entry.kind) << "\", ";
+            write_json_fields(out, entry, names);
+            out << "}\n";
+            break;
+        }
+    }
+}
+
+Report make_report(std::span<const size_t> dir1_items, std::span<const size_t> dir2_items, std::span<const PairMatch> matches, int percent_for_not_eq) {
+    Report report;
+    std::vector<bool> dir1_item_matched(dir1_items.size(), false);
+    std::vector<bool> dir2_item_matched(dir2_items.size(), false);
+    for (const PairMatch& match: matches) {
+        EntryKind kind = EntryKind::kIdentical;
+        if (!match.identical) {
+            // Процент округлён вниз, сравнение с порогом то же, что
+            //   cmn_substr_size * 100 >= max_size * percent_for_not_eq.
+            kind = match.percent >= static_cast<size_t>(percent_for_not_eq) ? EntryKind::kSimilar : EntryKind::kDifferent;
+        }
+        report.push_back(ReportEntry{kind, dir1_items[match.row], dir2_items[match.col], match.percent});
+        if (kind != EntryKind::kDifferent) {
+            dir1_item_matched[match.row] = true;
+            dir2_item_matched[match.col] = true;
+        }
+    }
+    for (size_t i = 0; i < dir1_items.size(); ++i) {
+        if (!dir1_item_matched[i]) {
+            report.push_back(ReportEntry{EntryKind::kOnlyInDir1, dir1_items[i], 0, 0});
+        }
+    }
+    for (size_t j = 0; j < dir2_items.size(); ++j) {
+        if (!dir2_item_matched[j]) {
+            report.push_back(ReportEntry{EntryKind::kOnlyInDir2, dir2_items[j], 0, 0});
+        }
+    }
+    return report;
+}
+
+void write_report(std::ostream& stream, OutputFormat format, const Report& report, std::span<const std::string> names) {
+    OutputBuffer out(stream);
+    switch (format) {
+    case OutputFormat::kText:
+        write_text(out, report, names);
+        break;
+    case OutputFormat::kSections:
+        write_sections(out, report, names);
+        break;
+    case OutputFormat::kCsv:
+        write_csv(out, report, names);
+        break;
+    case OutputFormat::kJson:
+        write_json(out, report, names);
+        break;
+    }
+}
+
+void write_report_diff(std::ostream& stream, OutputFormat format, const Report& old_report, const Report& new_report, std::span<const std::string> names) {
+    std::set<EntryKey> old_keys;
+    for (const ReportEntry& entry: old_report) {
+        old_keys.insert(entry_key(entry, names));
+    }
+    std::set<EntryKey> new_keys;
+    for (const ReportEntry& entry: new_report) {
+        new_keys.insert(entry_key(entry, names));
+    }
+
+    OutputBuffer out(stream);
+    for (const ReportEntry& entry: old_report) {
+        if (!new_keys.contains(entry_key(entry, names))) {
+            write_change(out, format, "removed", entry, names);
+        }
+    }
+    for (const ReportEntry& entry: new_report) {
+        if (!old_keys.contains(entry_key(entry, names))) {
+            write_change(out, format, "added", entry, names);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "comparison.hpp"
+
+enum class OutputFormat {
+    // Формат исходной программы: все пары построчно, у пар ниже
+    //   порога -- процент; затем файлы без пары одной строкой на
+    //   директорию через ';'.
+    kText,
+    // По частям, как в условии: одинаковые пары, затем похожие с
+    //   процентом, затем файлы без пары, как в kText.
+    kSections,
+    // Заголовок kind,file1,file2,percent и строка на запись.
+    kCsv,
+    // Объект с массивами identical, similar, only_in_dir1, only_in_dir2.
+    kJson,
+};
+
+enum class EntryKind {
+    kIdentical,
+    kSimilar,
+    // Пара ниже порога. Попадает в отчёт, только если такие пары
+    //   есть в matches, переданных make_report.
+    kDifferent,
+    kOnlyInDir1,
+    kOnlyInDir2,
+};
+
+// Запись отчёта. Файлы -- номера в корпусе, имена подставляются
+//   только при выводе. У файлов без пары file2 не используется.
+struct ReportEntry {
+    EntryKind kind = EntryKind::kIdentical;
+    size_t file1 = 0;
+    size_t file2 = 0;
+    size_t percent = 0;
+};
+
+// Записи: пары в порядке (row, col), затем файлы первой
+//   директории без пары, затем файлы второй без пары.
+using Report = std::vector<ReportEntry>;
+
+// Пары matches с процентом ниже percent_for_not_eq -- kDifferent,
+//   файлы таких пар парой не считаются.
+Report make_report(std::span<const size_t> dir1_items, std::span<const size_t> dir2_items, std::span<const PairMatch> matches, int percent_for_not_eq);
+
+// names[id] -- имя файла id в выводе. Вывод собирается в буфер
+//   и пишется в поток крупными кусками.
+void write_report(std::ostream& stream, OutputFormat format, const Report& report, std::span<const std::string> names);
+
+// Разница отчётов для режима наблюдения. Записи сравниваются по
+//   именам: у изменённого файла номер новый, а имя то же.
+//   Текст: строки "- " и "+ " в формате отчёта. CSV: столбец
+//   change (added/removed) перед записью. JSON: по объекту на
+//   строку с полем change.
+void write_report_diff(std::ostream& stream, OutputFormat format, const Report& old_report, const Report& new_report, std::span<const std::string> names);
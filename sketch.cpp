@@ -0,0 +1,89 @@
+#include "sketch.hpp"
+
+#include <algorithm>
+#include <deque>
+
+namespace {
+    // Полиномиальный хеш по модулю 2^64 с нечётным основанием.
+    constexpr uint64_t kBase = 0x100000001B3ull;
+
+    uint64_t mix(uint64_t value) {
+        // Перемешивание из MurmurHash3: минимум по окну должен
+        //   выбираться из равномерно распределённых значений.
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+}
+
+Sketch compute_sketch(std::span<const uint8_t> data) {
+    Sketch sketch;
+    if (data.size() < kSketchKgramLen) {
+        return sketch;
+    }
+
+    // base^(k - 1), чтобы убирать выходящий из k-граммы символ.
+    uint64_t base_pow = 1;
+    for (size_t i = 1; i < kSketchKgramLen; ++i) {
+        base_pow *= kBase;
+    }
+
+    uint64_t rolling = 0;
+    for (size_t i = 0; i < kSketchKgramLen; ++i) {
+        rolling = rolling * kBase + data[i];
+    }
+
+    // Минимум в скользящем окне: в очереди номера k-грамм с
+    //   возрастающими хешами. При равенстве берём правую, как
+    //   советуют авторы winnowing, это уменьшает число отпечатков.
+    const size_t num_kgrams = data.size() - kSketchKgramLen + 1;
+    const size_t window = std::min(kSketchWindow, num_kgrams);
+    // Пары (номер k-граммы, хеш).
+    std::deque<std::pair<size_t, uint64_t>> window_min;
+    size_t last_selected = SIZE_MAX;
+    for (size_t i = 0; i < num_kgrams; ++i) {
+        if (i != 0) {
+            rolling = (rolling - data[i - 1] * base_pow) * kBase + data[i + kSketchKgramLen - 1];
+        }
+        const uint64_t hash = mix(rolling);
+
+        while (!window_min.empty() && window_min.back().second >= hash) {
+            window_min.pop_back();
+        }
+        window_min.emplace_back(i, hash);
+        if (window_min.front().first + window <= i) {
+            window_min.pop_front();
+        }
+
+        if (i + 1 >= window && window_min.front().first != last_selected) {
+            last_selected = window_min.front().first;
+            sketch.push_back(window_min.front().second);
+        }
+    }
+
+    std::sort(sketch.begin(), sketch.end());
+    sketch.erase(std::unique(sketch.begin(), sketch.end()), sketch.end());
+    return sketch;
+}
+
+void SketchIndex::add(size_t file, const Sketch& sketch) {
+    for (uint64_t hash: sketch) {
+        entries_.emplace_back(hash, file);
+    }
+}
+
+void SketchIndex::build() {
+    std::sort(entries_.begin(), entries_.end());
+}
+
+void SketchIndex::find_candidates(const Sketch& sketch, std::vector<bool>& is_candidate) const {
+    for (uint64_t hash: sketch) {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), std::make_pair(hash, static_cast<size_t>(0)));
+        for (; it != entries_.end() && it->first == hash; ++it) {
+            is_candidate[it->second] = true;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Отпечатки файла по алгоритму winnowing (Шлейммер, Уилкерсон,
+//   Айкен). Считаем хеши всех подстрок длины kSketchKgramLen
+//   (k-грамм), в каждом окне из kSketchWindow подряд идущих
+//   k-грамм выбираем наименьший хеш -- это MinHash окна. Отпечаток
+//   файла -- множество выбранных хешей.
+// Гарантия: если у двух файлов есть общая подстрока длины хотя
+//   бы kSketchGuaranteedLen, то в ней целиком помещается окно, у
+//   обоих файлов это окно одно и то же, и его минимум попадёт в
+//   оба отпечатка. Значит, если отпечатки не пересекаются, общей
+//   подстроки такой длины нет, и пару можно не сравнивать точно.
+//   Коллизии хешей дают только лишние пересечения, пропустить
+//   похожую пару отпечатки не могут.
+constexpr size_t kSketchKgramLen = 16;
+constexpr size_t kSketchWindow = 32;
+constexpr size_t kSketchGuaranteedLen = kSketchWindow + kSketchKgramLen - 1;
+
+// Отсортированные различные хеши. В среднем выбирается
+//   2 / (kSketchWindow + 1) от числа k-грамм.
+using Sketch = std::vector<uint64_t>;
+
+Sketch compute_sketch(std::span<const uint8_t> data);
+
+// Версия compute_sketch, для кеша отпечатков, как
+//   kContentHashVersion. Увеличивать при изменении хеша k-грамм
+//   или выбора минимумов; kSketchKgramLen и kSketchWindow кеш
+//   проверяет сам.
+constexpr uint32_t kSketchVersion = 1;
+
+// Обратный индекс: по хешу -- файлы, в отпечатке которых он есть.
+//   Хранится одним отсортированным массивом пар, без хеш-таблицы
+//   на каждый хеш.
+class SketchIndex {
+public:
+    void add(size_t file, const Sketch& sketch);
+    // После добавления всех файлов и до запросов.
+    void build();
+
+    // Отмечает в is_candidate (размера не меньше числа файлов)
+    //   файлы, с которыми у отпечатка есть общий хеш.
+    void find_candidates(const Sketch& sketch, std::vector<bool>& is_candidate) const;
+
+private:
+    std::vector<std::pair<uint64_t, size_t>> entries_;
+};
@@ -0,0 +1,109 @@
+#include "stats.hpp"
+
+#include <ctime>
+#include <iterator>
+
+#include <sys/resource.h>
+
+namespace {
+    constexpr const char* kPhaseNames[] = {
+        "ingest",
+        "sketch",
+        "chunk",
+        "candidates",
+        "substr_check",
+        "engine",
+        "output",
+        "suffix_array",
+        "lcp",
+        "suffix_automaton_build",
+        "suffix_automaton_query",
+    };
+    static_assert(std::size(kPhaseNames) == static_cast<size_t>(Phase::kCount));
+
+    constexpr const char* kCounterNames[] = {
+        "files",
+        "chunks",
+        "pairs",
+        "pairs_deduplicated",
+        "pairs_identical",
+        "pairs_pruned_by_size",
+        "pairs_pruned_by_sketch",
+        "pairs_pruned_by_substr_check",
+        "pairs_compared",
+        "pairs_bounded",
+        "pairs_similar",
+        "sa_is_levels",
+        "doubling_rounds",
+    };
+    static_assert(std::size(kCounterNames) == static_cast<size_t>(Counter::kCount));
+
+    uint64_t now_ns(clockid_t clock) {
+        timespec time;
+        clock_gettime(clock, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    bool is_program_phase(Phase phase) {
+        return phase < Phase::kSuffixArray;
+    }
+
+    double to_seconds(uint64_t ns) {
+        return static_cast<double>(ns) / 1e9;
+    }
+}
+
+Stats& Stats::global() {
+    static Stats stats;
+    return stats;
+}
+
+void Stats::add_phase(Phase phase, uint64_t wall_ns, uint64_t cpu_ns, uint64_t bytes) {
+    PhaseTotals& totals = phases_[static_cast<size_t>(phase)];
+    totals.calls.fetch_add(1, std::memory_order_relaxed);
+    totals.wall_ns.fetch_add(wall_ns, std::memory_order_relaxed);
+    totals.cpu_ns.fetch_add(cpu_ns, std::memory_order_relaxed);
+    totals.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Stats::write_json(std::ostream& stream) const {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    stream << "{\n  \"phases\": {";
+    for (size_t phase = 0; phase < phases_.size(); ++phase) {
+        const PhaseTotals& totals = phases_[phase];
+        stream << (phase == 0 ? "\n" : ",\n") << "    \"" << kPhaseNames[phase] << "\": {"
+               << "\"calls\": " << totals.calls.load(std::memory_order_relaxed)
+               << ", \"wall_s\": " << to_seconds(totals.wall_ns.load(std::memory_order_relaxed))
+               << ", \"cpu_s\": " << to_seconds(totals.cpu_ns.load(std::memory_order_relaxed))
+               << ", \"bytes\": " << totals.bytes.load(std::memory_order_relaxed) << "}";
+    }
+    stream << "\n  },\n  \"counters\": {";
+    for (size_t counter = 0; counter < counters_.size(); ++counter) {
+        stream << (counter == 0 ? "\n" : ",\n") << "    \"" << kCounterNames[counter] << "\": " << counters_[counter].load(std::memory_order_relaxed);
+    }
+    stream << "\n  },\n"
+           << "  \"cpu_s\": " << to_seconds(now_ns(CLOCK_PROCESS_CPUTIME_ID)) << ",\n"
+           << "  \"peak_rss_bytes\": " << static_cast<uint64_t>(usage.ru_maxrss) * 1024 << "\n}\n";
+}
+
+PhaseTimer::PhaseTimer(Phase phase, uint64_t bytes): phase_(phase), bytes_(bytes), active_(Stats::global().enabled()) {
+    if (active_) {
+        wall_start_ = now_ns(CLOCK_MONOTONIC);
+        cpu_start_ = now_ns(is_program_phase(phase_) ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID);
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    stop();
+}
+
+void PhaseTimer::stop() {
+    if (active_) {
+        const uint64_t wall = now_ns(CLOCK_MONOTONIC) - wall_start_;
+        const uint64_t cpu = now_ns(is_program_phase(phase_) ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID) - cpu_start_;
+        Stats::global().add_phase(phase_, wall, cpu, bytes_);
+        active_ = false;
+    }
+}
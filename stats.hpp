@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Замеры по этапам работы и счётчики для --stats. Пока замеры
+//   не включены, таймер этапа и счётчик -- одна проверка флага.
+//   Включаются до запуска потоков и дальше не меняются.
+
+enum class Phase {
+    // Этапы программы, замеряются в главном потоке. Время
+    //   процессора -- всего процесса, со всеми потоками.
+    kIngest,
+    kSketch,
+    kChunk,
+    kCandidates,
+    kSubstrCheck,
+    kEngine,
+    kOutput,
+    // Вызовы алгоритмов, в том числе из рабочих потоков. Время
+    //   суммируется по вызовам, процессорное -- потока вызова.
+    kSuffixArray,
+    kLcp,
+    kSuffixAutomatonBuild,
+    kSuffixAutomatonQuery,
+    kCount,
+};
+
+enum class Counter {
+    kFiles,
+    kChunks,
+    kPairs,
+    // Пары, ответ для которых взят у копий того же содержимого.
+    kPairsDeduplicated,
+    kPairsIdentical,
+    kPairsPrunedBySize,
+    kPairsPrunedBySketch,
+    kPairsPrunedBySubstrCheck,
+    kPairsCompared,
+    // Пары, индекс для которых не поместился в память: посчитаны
+    //   bounded_cmn_substr_len.
+    kPairsBounded,
+    kPairsSimilar,
+    // Уровни рекурсии SA-IS и раунды удвоения Манбера-Майерса.
+    kSaIsLevels,
+    kDoublingRounds,
+    kCount,
+};
+
+class Stats {
+public:
+    static Stats& global();
+
+    void enable() {
+        enabled_ = true;
+    }
+
+    bool enabled() const {
+        return enabled_;
+    }
+
+    void add_phase(Phase phase, uint64_t wall_ns, uint64_t cpu_ns, uint64_t bytes);
+
+    void add(Counter counter, uint64_t value = 1) {
+        if (enabled_) {
+            counters_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    void write_json(std::ostream& stream) const;
+
+private:
+    struct PhaseTotals {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> wall_ns{0};
+        std::atomic<uint64_t> cpu_ns{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    bool enabled_ = false;
+    std::array<PhaseTotals, static_cast<size_t>(Phase::kCount)> phases_;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::kCount)> counters_{};
+};
+
+// Замеряет этап от создания до разрушения. bytes -- сколько
+//   данных этап обработал.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase, uint64_t bytes = 0);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    // Для этапов, объём которых известен только в конце.
+    void add_bytes(uint64_t bytes) {
+        bytes_ += bytes;
+    }
+
+    // Заканчивает замер раньше разрушения.
+    void stop();
+
+private:
+    Phase phase_;
+    uint64_t bytes_;
+    bool active_;
+    uint64_t wall_start_ = 0;
+    uint64_t cpu_start_ = 0;
+};
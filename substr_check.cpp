@@ -0,0 +1,225 @@
+#include "substr_check.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+#include "byte_compare.hpp"
+
+namespace {
+    constexpr uint64_t kBase = 0x100000001B3ull;
+    constexpr size_t kEmpty = SIZE_MAX;
+
+    uint64_t polynomial_hash(const uint8_t* data, size_t len) {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < len; ++i) {
+            hash = hash * kBase + data[i];
+        }
+        return hash;
+    }
+
+    // Открытая адресация с линейным пробированием: хеш -> номер.
+    //   Каждый хеш лежит в таблице один раз, поэтому цепочка
+    //   пробирования не растёт от повторов.
+    class HashIndex {
+    public:
+        explicit HashIndex(size_t max_size)
+            : hashes_(std::bit_ceil(2 * max_size)), values_(hashes_.size(), kEmpty),
+              // Младшие биты полиномиального хеша зависят только от
+              //   последних символов, потому ячейку берём из старших
+              //   бит произведения.
+              shift_(64 - std::countr_zero(hashes_.size())) {
+        }
+
+        // Ячейка с хешем hash или пустая, куда его класть.
+        size_t find(uint64_t hash) const {
+            const size_t mask = hashes_.size() - 1;
+            size_t slot = static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> shift_) & mask;
+            while (values_[slot] != kEmpty && hashes_[slot] != hash) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        size_t value(size_t slot) const {
+            return values_[slot];
+        }
+
+        void set(size_t slot, uint64_t hash, size_t value) {
+            hashes_[slot] = hash;
+            values_[slot] = value;
+        }
+
+    private:
+        std::vector<uint64_t> hashes_;
+        std::vector<size_t> values_;
+        int shift_ = 0;
+    };
+
+    // Серия одинаковых байт [begin, end) вокруг позиции pos.
+    struct Run {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    Run run_around(std::span<const uint8_t> data, size_t pos) {
+        Run run{pos, pos};
+        while (run.begin != 0 && data[run.begin - 1] == data[pos]) {
+            --run.begin;
+        }
+        while (run.end != data.size() && data[run.end] == data[pos]) {
+            ++run.end;
+        }
+        return run;
+    }
+
+    // Якорь: k-грамма индексированной строки с позиции pos. Якоря
+    //   с одной k-граммой связаны в список через next.
+    struct Anchor {
+        size_t pos = 0;
+        size_t next = kEmpty;
+        // Якорь внутри серии одного байта длиной от k: тогда
+        //   run -- вся серия, и якорь на неё один.
+        bool in_run = false;
+        Run run;
+    };
+}
+
+bool has_cmn_substr_of_len(std::span<const uint8_t> first, std::span<const uint8_t> second, size_t min_len) {
+    if (min_len == 0) {
+        return true;
+    }
+    if (min_len > std::min(first.size(), second.size())) {
+        return false;
+    }
+
+    // Индексируем меньшую строку, по большей проходим.
+    std::span<const uint8_t> indexed = first.size() <= second.size() ? first : second;
+    std::span<const uint8_t> scanned = first.size() <= second.size() ? second : first;
+
+    const size_t kgram_len = (min_len + 1) / 2;
+    const size_t step = min_len - kgram_len + 1;
+
+    uint64_t base_pow = 1;
+    for (size_t i = 1; i < kgram_len; ++i) {
+        base_pow *= kBase;
+    }
+
+    // Есть ли на диагонали через indexed[i] и scanned[j] совпадение
+    //   длины min_len, которое начинается не левее чем за max_left
+    //   символов до них.
+    auto covers = [&](size_t i, size_t j, size_t max_left) {
+        const size_t left = common_suffix_len(indexed.data() + i, scanned.data() + j, std::min({max_left, i, j, min_len}));
+        const size_t right_limit = std::min({indexed.size() - i, scanned.size() - j, min_len - left});
+        return left + common_prefix_len(indexed.data() + i, scanned.data() + j, right_limit) >= min_len;
+    };
+
+    // Якоря с одинаковым окружением [pos - (step - 1), pos + min_len)
+    //   дают при проверке одно и то же, в список k-граммы попадает
+    //   один из них. Так повторяющиеся записи дают один якорь, а
+    //   не по якорю на повтор. Окружение сравнивается целиком, не
+    //   только по хешу. Якоря у краёв строки не склеиваются.
+    // Якорь в серии одного байта (нулевое заполнение) один на серию:
+    //   серии сравниваются целиком, см. ниже.
+    const size_t window_len = step - 1 + min_len;
+    const size_t max_anchors = (indexed.size() - kgram_len) / step + 1;
+    HashIndex kgrams(max_anchors);
+    HashIndex windows(max_anchors);
+    std::vector<Anchor> anchors;
+    Run last_run;
+    for (size_t pos = 0; pos + kgram_len <= indexed.size(); pos += step) {
+        if (pos + kgram_len <= last_run.end) {
+            // Та же серия, что у предыдущего якоря.
+            continue;
+        }
+        Anchor anchor;
+        anchor.pos = pos;
+        // k-грамма из одного символа есть всегда, серией её не считаем.
+        if (kgram_len > 1 && common_prefix_len(indexed.data() + pos, indexed.data() + pos + 1, kgram_len - 1) == kgram_len - 1) {
+            anchor.in_run = true;
+            anchor.run = run_around(indexed, pos);
+            last_run = anchor.run;
+        } else if (pos >= step - 1 && pos + min_len <= indexed.size()) {
+            const uint8_t* window = indexed.data() + pos - (step - 1);
+            const uint64_t window_hash = polynomial_hash(window, window_len);
+            const size_t slot = windows.find(window_hash);
+            if (windows.value(slot) == kEmpty) {
+                windows.set(slot, window_hash, anchors.size());
+            } else {
+                const uint8_t* other = indexed.data() + anchors[windows.value(slot)].pos - (step - 1);
+                if (common_prefix_len(window, other, window_len) == window_len) {
+                    continue;
+                }
+            }
+        }
+
+        const uint64_t hash = polynomial_hash(indexed.data() + pos, kgram_len);
+        const size_t slot = kgrams.find(hash);
+        anchor.next = kgrams.value(slot);
+        kgrams.set(slot, hash, anchors.size());
+        anchors.push_back(anchor);
+    }
+
+    uint64_t rolling = polynomial_hash(scanned.data(), kgram_len);
+    for (size_t pos = 0; pos + kgram_len <= scanned.size();) {
+        size_t next_pos = pos + 1;
+        for (size_t index = kgrams.value(kgrams.find(rolling)); index != kEmpty; index = anchors[index].next) {
+            const Anchor& anchor = anchors[index];
+            if (!anchor.in_run) {
+                // Якорь совпал по хешу с pos. Общая подстрока длины
+                //   min_len, если она есть, начинается не раньше чем
+                //   за step - 1 символ до якоря, и ей нужно min_len
+                //   символов справа от своего начала.
+                if (covers(anchor.pos, pos, step - 1)) {
+                    return true;
+                }
+                continue;
+            }
+            // k-грамма -- серия байта c, и в scanned с pos тоже. Все
+            //   позиции серии scanned дают ту же k-грамму, проходить
+            //   их по одной -- квадрат от длины серии. На диагонали,
+            //   где серии не выровнены ни по началу, ни по концу,
+            //   совпадение -- только их пересечение, не длиннее
+            //   меньшей серии. Выровненная по началу диагональ
+            //   содержит его целиком и, может быть, продолжается,
+            //   поэтому достаточно проверить две выровненные.
+            if (common_prefix_len(scanned.data() + pos, indexed.data() + anchor.pos, kgram_len) != kgram_len) {
+                continue;
+            }
+            const Run run = run_around(scanned, pos);
+            if (covers(anchor.run.begin, run.begin, min_len) || covers(anchor.run.end, run.end, min_len)) {
+                return true;
+            }
+            next_pos = std::max(next_pos, run.end - kgram_len + 1);
+        }
+
+        if (next_pos == pos + 1) {
+            if (next_pos + kgram_len <= scanned.size()) {
+                rolling = (rolling - scanned[pos] * base_pow) * kBase + scanned[pos + kgram_len];
+            }
+        } else if (next_pos + kgram_len <= scanned.size()) {
+            rolling = polynomial_hash(scanned.data() + next_pos, kgram_len);
+        }
+        pos = next_pos;
+    }
+
+    return false;
+}
+
+size_t bounded_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second, size_t min_percent) {
+    const size_t max_size = std::max(first.size(), second.size());
+    auto len_for_percent = [&](size_t percent) {
+        return (max_size * percent + 99) / 100;
+    };
+    size_t low = min_percent;
+    size_t high = 100;
+    while (low < high) {
+        const size_t middle = (low + high + 1) / 2;
+        if (has_cmn_substr_of_len(first, second, len_for_percent(middle))) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return len_for_percent(low);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Есть ли у строк общая подстрока длины хотя бы min_len. Это
+//   всё, что нужно, чтобы отбросить пару ниже порога, и ответ
+//   обычно получается одним линейным проходом, без суффиксных
+//   структур.
+// Если общая подстрока длины min_len есть, то в ней лежит
+//   подстрока длины k = ceil(min_len / 2), начинающаяся в
+//   первой строке в позиции, кратной step = min_len - k + 1.
+//   Потому индексируем хешами только такие k-граммы одной
+//   строки (их около 2n / min_len), проходим скользящим хешем
+//   по всем k-граммам другой и при совпадении хеша проверяем,
+//   продолжается ли совпадение до длины min_len. Возвращаемся
+//   на первой найденной подстроке.
+// Каждая k-грамма хранится один раз со списком якорей; якоря с
+//   одинаковым окружением склеиваются. Серии одного байта длиной
+//   от k (нулевое заполнение) сравниваются целиком по двум
+//   диагоналям, а не с каждой позиции серии, поэтому повторы и
+//   заполнение не делают проверку квадратичной.
+bool has_cmn_substr_of_len(std::span<const uint8_t> first, std::span<const uint8_t> second, size_t min_len);
+
+// Сходство пары без суффиксных структур, для строк, индекс по
+//   которым не помещается в память. Процент сходства --
+//   floor(lcs * 100 / max_size), и он ищется двоичным поиском:
+//   общая подстрока длины ceil(max_size * q / 100) есть ровно при
+//   q не больше процента, а проверка на каждом шаге -- вызов
+//   has_cmn_substr_of_len, которому нужно O(n / длина) памяти, то
+//   есть O(100 / q) ячеек. Шагов не больше семи.
+// Общая подстрока для min_percent должна быть уже известна.
+//   Возвращает длину, которая даёт тот же процент, что и
+//   наидлиннейшая общая подстрока, и так же проходит порог.
+size_t bounded_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second, size_t min_percent);
@@ -0,0 +1,83 @@
+// Сверяет has_cmn_substr_of_len и bounded_cmn_substr_len с
+//   наидлиннейшей общей подстрокой, посчитанной перебором, на
+//   коротких случайных строках. Маленький алфавит даёт много
+//   повторов и совпадений хешей k-грамм.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "substr_check.hpp"
+
+namespace {
+    // Динамика по парам позиций: длина общего суффикса префиксов.
+    size_t brute_force_lcs_len(const std::vector<uint8_t>& first, const std::vector<uint8_t>& second) {
+        std::vector<size_t> previous(second.size() + 1, 0);
+        std::vector<size_t> current(second.size() + 1, 0);
+        size_t result = 0;
+        for (size_t i = 1; i <= first.size(); ++i) {
+            for (size_t j = 1; j <= second.size(); ++j) {
+                current[j] = first[i - 1] == second[j - 1] ? previous[j - 1] + 1 : 0;
+                result = std::max(result, current[j]);
+            }
+            std::swap(previous, current);
+        }
+        return result;
+    }
+
+    std::vector<uint8_t> make_string(size_t size, size_t alphabet_size, std::mt19937_64& rng) {
+        std::vector<uint8_t> data(size);
+        for (uint8_t& chr: data) {
+            chr = static_cast<uint8_t>(rng() % alphabet_size);
+        }
+        return data;
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(1);
+    size_t num_failures = 0;
+    for (size_t iteration = 0; iteration < 20000; ++iteration) {
+        const size_t alphabet_size = 1 + rng() % 4;
+        std::vector<uint8_t> first = make_string(rng() % 40, alphabet_size, rng);
+        std::vector<uint8_t> second = make_string(rng() % 40, alphabet_size, rng);
+        // Вторая строка иногда -- кусок первой, чтобы были и
+        //   длинные общие подстроки.
+        if (iteration % 3 == 0 && !first.empty()) {
+            const size_t begin = rng() % first.size();
+            const size_t end = begin + rng() % (first.size() - begin + 1);
+            second.insert(second.begin() + static_cast<std::ptrdiff_t>(rng() % (second.size() + 1)), first.begin() + static_cast<std::ptrdiff_t>(begin), first.begin() + static_cast<std::ptrdiff_t>(end));
+        }
+
+        const size_t lcs_len = brute_force_lcs_len(first, second);
+        for (size_t len = 0; len <= std::max(first.size(), second.size()) + 1; ++len) {
+            if (has_cmn_substr_of_len(first, second, len) != (lcs_len >= len)) {
+                std::cerr << "has_cmn_substr_of_len: sizes " << first.size() << ", " << second.size() << ", lcs " << lcs_len << ", len " << len << '\n';
+                ++num_failures;
+            }
+        }
+
+        // Как в сравнении: процент floor(lcs * 100 / max_size), и
+        //   bounded_cmn_substr_len вызывается для пар не ниже порога.
+        const size_t max_size = std::max(first.size(), second.size());
+        if (max_size == 0) {
+            continue;
+        }
+        const size_t percent = lcs_len * 100 / max_size;
+        for (size_t min_percent = 0; min_percent <= percent; min_percent += 1 + rng() % 10) {
+            const size_t bounded_len = bounded_cmn_substr_len(first, second, min_percent);
+            if (bounded_len > lcs_len || bounded_len * 100 / max_size != percent) {
+                std::cerr << "bounded_cmn_substr_len: sizes " << first.size() << ", " << second.size() << ", lcs " << lcs_len << ", min_percent " << min_percent << ", got " << bounded_len << '\n';
+                ++num_failures;
+            }
+        }
+    }
+
+    if (num_failures != 0) {
+        std::cerr << num_failures << " checks failed\n";
+        return 1;
+    }
+    return 0;
+}
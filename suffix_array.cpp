@@ -0,0 +1,1047 @@
+#include "suffix_array.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <type_traits>
+
+#include "byte_compare.hpp"
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "workspace.hpp"
+
+namespace {
+
+// Work -- тип позиций во временных массивах, Index -- в
+//   результате. Временных массивов пять, и каждая итерация
+//   проходит по ним сортировкой подсчётом, потому 32-битные
+//   позиции вдвое уменьшают и память, и трафик.
+template<typename Work, typename Index, typename Char>
+void prefix_doubling(std::span<const Char> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace) {
+
+    // Алгоритм Манбера-Майерса. Строим суффиксный массив за
+    //   O(n log(n)) сортировкой зацикленных циклических сдвигов.
+    // Допишем нулевой символ в конец, который меньше всех остальных.
+    // Теперь суффикс из нулевого символа находится в начале массива.
+    // Лексикографический порядок суффиксов не изменится (к ним
+    //   просто дописался ноль):
+    //   если не один из двух суффиксов не был префиксом другого,
+    //   то в какой-то момент они начинают отличаться, до нуля
+    //   сравнение не доходит;
+    //   если был, то суффикс меньшей длины префикс суффикса большей,
+    //   раньше сравнение завершалось из-за разной длины строк, но
+    //   теперь у строки меньшей длины появляется нулевой символ
+    //   раньше.
+    // Теперь в конце суффиксов есть нулевой байт. Можем после этого
+    //   байта дописать любые строки, порядок суффиксов не изменится:
+    //   все суффиксы разной длины, потому там находится 0 в разных
+    //   позициях. До дописанной строки сравнение никогда не дойдет,
+    //   поскольку на первом нуле выяснится порядок, кто меньше. У
+    //   кого встретился ноль, то и меньше.
+    // Тогда допишем к суффиксам ноль, а потом недостающие символы
+    //   из начала, а затем зациклим эту строку, сделав бесконечной.
+    //   Достаточно отсортировать эти бесконечные строки по первым n
+    //   символам, где n -- длина строки, и всё будет готово. Давайте
+    //   отсортируем по первой степени двойки, которая больше или
+    //   равна n. Сортировать будем сортировками подсчётом за O(n),
+    //   количество сравниваемых строк -- n + 1, это O(n), будет
+    //   log_2(n) итераций. Потому O(n log(n)).
+    // Можно дописывать не нулевой символ, а строго меньший всех
+    //   остальных в строке. Все доказательства будут работать.
+    // Для нашей задачи сдвинем все символы на один вверх и
+    //   допишем ноль, он заведомо меньше.
+    // Пусть S_i -- номер отрезка совпадающих элементов i-го суффикса
+    //   после сортировки с k-ой итерации.
+    //   Как понять, что это такое? В результате любой сортировки
+    //   у нас сначала идут числа с наименьшим значением, затем
+    //   со вторым наибольшим и так далее. И числа с наименьшим,
+    //   если их было несколько, образуют отрезок. Аналогично числа
+    //   со вторым наименьшим значением и так далее.
+    //   Это же происходит и при лексикографической сортировке строк:
+    //     сначала сколько строк одинаковых, наименьших лексикографически,
+    //     затем строки вторые лексикогарфически и так далее. Внутри
+    //     отрезка находятся одинаковые строки, т.е. это просто одинаковые
+    //     строки из набора. Пронумеруем эти отрезки с нуля, по индексу из
+    //     исходного массива будем получать номер такого отрезка, где
+    //     элемент оказался.
+    //   В нашем случае мы сортируем по первым 2^k символам, потому по первым
+    //     k символам строки совпадают. И сами строки не храним, а храним их
+    //     начала в исходной строке.
+    //   Это ещё называют лексикографическим именем (алгоритм
+    //   Каркайнена-Сандерса, построение суфмассива за O(n)), компонентой
+    //   эквивалентности в разборах нашего алгоритма, что имеет смысл, т.к.
+    //    внутри отрезка все элементы равны.
+    // Пусть M_j -- отсортированный массив с началами суффиксов с итерации k.
+    // На итерации k + 1 надо отсортировать пары (S_i, S_{i + 2^k}).
+    //   Отсортировать по второй половине легко: возьмём M'_j = M_{j + 2^k},
+    //   зациклив индекс. Почему это то же самое, что отсортировать по второй
+    //   половине? TODO: посмотреть разбор этого алгоса, дописать. Сейчас я
+    //   TODO: просто знаю, что надо делать.
+    // Чтобы выучить алгоритм, рекомендую записать эти шаги, держать их в
+    //   голове.
+
+    // Этапы:
+    //  1) дополнение строки,
+    //  1.1) почему дополняем, порядок суффиксов не меняется?
+    //  1.2) почему ...
+    //  1.2) почему ...
+    //  1.2) почему ...
+    //  1.3) почему можно сортировать по первым ceil(log_2(n)) символам и всё ок?
+    //  2) сортировка по первому символа (2^k, k = 0),
+    //  3) сортировка 2^(k + 1), если отсортировано по 2^k:
+    //   3.1) сортировка по второй половине пары, почему действительно отсортровали.
+
+    // Для 1.3 что-то такое можно использовать.
+    // Сортируем зацикленные циклические сдвиги по первым 2^len_log символам.
+    // После сортировать нет смысла, т.к. результаты сравнений не поменяются,
+    //   потому что у всех зацикленных циклических суффиксов есть решетка,
+    //   у различных по длине она в разных местах, потому знак
+    //   неравенства становится гарантированно известен после просмотра
+    //   первых text.size() символов: обязательно встретим решетку, она
+    //   не совпадёт. Мб и раньше будет несовпадение.
+
+    assert(!text.empty());
+
+    // Все временные массивы берутся из workspace и возвращаются
+    //   при выходе, из кучи память не выделяется.
+    WorkspaceScope scope(workspace);
+
+    // Этап 1: дополнение строки.
+    std::span<uint32_t> text_mod = workspace.allocate<uint32_t>(text.size() + 1);
+    for (size_t i = 0; i < text.size(); ++i) {
+        text_mod[i] = static_cast<uint32_t>(text[i]) + 1;
+    }
+    text_mod[text.size()] = 0;
+
+    // Общие массивы для этапов, остаются с предыдущей итерации
+    //   для новой.
+    std::span<Work> sorted_items = workspace.allocate<Work>(text_mod.size());
+    std::span<Work> component_by_item = workspace.allocate<Work>(text_mod.size());
+
+    // Этап 2.
+    // Сортируем по первому символу, это первые 2^k
+    //   символов для k = 0.
+    // Для сортировок подсчётом на следующих итерациях
+    //   надо знать алфавит, чтобы выделить массив.
+    //   Наш алфавит -- номера компонент эквивалентности.
+    //   На (k+1)-ой итерации мы сортируем по номерам с
+    //   предыдущей итерации: TODO: ПРОВЕРИТЬ, КОГДА НАПИШУ КОД.
+    //   Потому можно выделить массив на длину строки элементов,
+    //   т.к. номер компоненты начинается с нуля и их не больше,
+    //   чем суффиксов +1, это длина text_mod. Единственное, в
+    //   чем беда: при сортировке подсчётом по первому символу
+    //   номер компоненты равен номеру символа в алфавите.
+    //   Пересчитаем номер компоненты заново после сортировки, что там.
+    const size_t src_str_alphabet_max_chr = *std::max_element(text_mod.begin(), text_mod.end());
+    // Массив счётчиков для всех сортировок подсчётом, выделяем
+    //   один раз на наибольший алфавит: символы или компоненты.
+    std::span<Work> num_occurs_buffer = workspace.allocate<Work>(std::max(src_str_alphabet_max_chr + 1, text_mod.size()));
+    // Сортируем строки длины 1.
+    {
+        std::span<Work> num_occurs = num_occurs_buffer.first(src_str_alphabet_max_chr + 1);
+        std::fill(num_occurs.begin(), num_occurs.end(), 0);
+        for (size_t i = 0; i < text_mod.size(); ++i) {
+            const size_t digit = text_mod[i];
+            num_occurs[digit] += 1;
+        }
+        // Исключающие префиксные суммы, как говорят публикации
+        //   алгоритма Каркайнена-Сандерса.
+        // Вообще, можно делать стабильную сортировку подсчётом
+        //  двумя способами: считать исключающие суммы,
+        //  количество элементов до компоненты, тогда перебирать
+        //  в прямом порядке отсоритрованный массив, в каждую
+        //  компоненту попадает наименьший. Или хранить включая,
+        //  тогда перебирать в обратном, в каждую компоненту
+        //  попадает наибольший, в конец компоненты.
+        std::span<Work> num_items_before_digit = num_occurs;
+        size_t cur_digit_num_items_before = 0;
+        for (size_t i = 0; i <= src_str_alphabet_max_chr; ++i) {
+            size_t num_occurences = num_occurs[i];
+            num_items_before_digit[i] = static_cast<Work>(cur_digit_num_items_before);
+            // For the next iteration this pos is included.
+            cur_digit_num_items_before += num_occurences;
+        }
+        for (size_t i = 0; i < text_mod.size(); ++i) {
+            const size_t digit = text_mod[i];
+            sorted_items[num_items_before_digit[digit]] = static_cast<Work>(i);
+            num_items_before_digit[digit] += 1;
+        }
+        // Считаем номера компонент эквивалентности.
+        component_by_item[sorted_items[0]] = 0;
+        for (size_t i = 1; i < sorted_items.size(); ++i) {
+            // Пока это ещё символы, можно смотреть в текст.
+            //   Дальше придется смотреть номера компонент
+            //   эквивалентности. И тогда понадобится новый
+            //   массив, чтобы не перезаписывать старые
+            //   значения.
+            // TODO: make this implementation detail, don't think about it.
+            // TODO: make a small version of this algo, on associative containers,
+            //   in python, so that it's small and concise, ready to be memorised.
+            if (text_mod[sorted_items[i]] != text_mod[sorted_items[i - 1]]) {
+                component_by_item[sorted_items[i]] = component_by_item[sorted_items[i - 1]] + 1;
+            } else {
+                component_by_item[sorted_items[i]] = component_by_item[sorted_items[i - 1]];
+            }
+        }
+    }
+
+    // TODO: write step text here. Read the original article, explain better.
+    // Для перехода к следующей итерации нам нужна дополнительная память:
+    //   новый порядок, потому что мы сортируем по второй половине
+    //   сдвигом, чтобы воспользоваться в стабильной сортировке подсчётом.
+    //   Но резуьтат сортировки подсчётом мы при этом процессе записываем
+    //   в старый;
+    //   и старые номера компонент по элементам, это наши цифры в сортироке
+    //   подсчётом, т.к. мы после сортировки должны получить новые номера
+    //   компонент по обоим парам, не только по первой, при этом мы
+    //   используем массив старых компонент, чтобы сравнивать.
+    // Мы не можем и проходится по старому, и писать туда новый порядок,
+    //   т.к. это перезатрёт позиции, в которые мы ещё не зашли.
+    // Если пишете какой-то алгоритм в первый раз, создавайте максимальное
+    //   количество массивов, для каждой величины по смыслу: новые величины
+    //   после итерации, старые до итерации и т.п. Потом в конце итерации
+    //   замените старые на новые.
+    std::span<Work> new_sorted_items = workspace.allocate<Work>(text_mod.size());
+    std::span<Work> new_component_by_item = workspace.allocate<Work>(text_mod.size());
+    // ull to avoid comparision between signed and unsigned, it's
+    //   a warning. Don't think about it when you write it first
+    //   time, you'll fix that.
+    //   TODO: сделать секцию: особенности реализации на C++, там это указать.
+    // While previous iteration was not enough.
+    // (1ull << (len_log - 1)) < text_mod.size() is wrong. What'll happen?
+    //   We need to sort by more than, length characters, This will stop
+    //   the first time it's greater than length, without sorting!
+    //   It may become greater, just only once! If it wasn't greater or
+    //   equal before.
+    for (size_t len_log = 1; (1ull << (len_log - 1)) < text_mod.size(); ++len_log) {
+        Stats::global().add(Counter::kDoublingRounds);
+        // Сортируем по второй половине, просто сдвинув
+        //   индексы: для каждой второй половины индекс
+        //   первой половины определяется однозначно, а
+        //   как отсортированы вторые половины знаем.
+        const size_t len = static_cast<size_t>(1) << len_log;
+        const size_t half_len = len / 2;
+        // Отсортированы суффиксы по первым 2^(k - 1) символам.
+        // Это вторые половины некоторых строк, т.к.
+        //   строки зациклены.
+        // Детально: просто возьмём любой суффикс, возьмём
+        //   вторую половину из первых 2^k символов. Это тоже
+        //   некоторый суффикс. И мы знаем порядок всех таких
+        //   суффиксов, если оставим их и отсортируем
+        //   (мультимножества строк совпадают).
+        // Переидем к первым половинам, вычтя половину длины,
+        //   получим упорядочивание строк длины 2^k по вторым
+        //   половинам. Т.е. мы знаем строку с минимальной
+        //   первой половиной, со второй по величине, если
+        //   просто произведем операции. Тогда просто к каждой
+        //   применим эту операцию и получим упорядочивание.
+        // TODO: найти это в оригинальной публикации, посмотреть, как там пишут, обсудить.
+        for (size_t i = 0; i < text_mod.size(); ++i) {
+            new_sorted_items[i] = static_cast<Work>((sorted_items[i] + text_mod.size() - half_len) % text_mod.size());
+        }
+        // Сортировка по второй половине закончена.
+
+        // Сортируем по первой половине (по компоненте первого элемента пары) подсчётом.
+        // Сдвигов n, потому компонент эквивалентности нужно не более, чем n.
+        // Чтобы сортировать устойчиво по второй половине, нам нужно проходить
+        //   по элементам в перевернутом отсортированном порядке.
+        //   Нам нужен отсортрованный порядок, потому будем его хранить.
+        // Массив счётчиков общий на все итерации, только обнуляем.
+        // Типичная сортировка подсчётом, правда алфавит -- компоненты
+        //   эквивалентности с прошлого шага.
+        {
+            std::span<Work> num_occurs = num_occurs_buffer.first(text_mod.size());
+            std::fill(num_occurs.begin(), num_occurs.end(), 0);
+            for (size_t i = 0; i < text_mod.size(); ++i) {
+                const size_t digit = component_by_item[i];
+                num_occurs[digit] += 1;
+            }
+            // Исключающие префиксные суммы, как говорят публикации
+            //   алгоритма Каркайнена-Сандерса.
+            std::span<Work> num_items_before_digit = num_occurs;
+            size_t cur_digit_num_items_before = 0;
+            for (size_t i = 0; i < num_occurs.size(); ++i) {
+                size_t num_occurences = num_occurs[i];
+                num_items_before_digit[i] = static_cast<Work>(cur_digit_num_items_before);
+                // For the next iteration this pos is included.
+                cur_digit_num_items_before += num_occurences;
+            }
+            // Перебираем пары в порядке сортировки по второй половине.
+            for (Work i: new_sorted_items) {
+                // Берем компоненту первой половины.
+                const size_t digit = component_by_item[i];
+                sorted_items[num_items_before_digit[digit]] = static_cast<Work>(i);
+                num_items_before_digit[digit] += 1;
+            }
+            // Считаем номера компонент эквивалентности.
+            new_component_by_item[sorted_items[0]] = 0;
+            for (size_t i = 1; i < sorted_items.size(); ++i) {
+                size_t prev_item = sorted_items[i - 1];
+                size_t cur_item = sorted_items[i];
+
+                size_t prev_item_first_half_comp  = component_by_item[prev_item];
+                size_t prev_item_second_half_comp = component_by_item[(prev_item + half_len) % text_mod.size()];
+
+                size_t cur_item_first_half_comp  = component_by_item[cur_item];
+                size_t cur_item_second_half_comp = component_by_item[(cur_item + half_len) % text_mod.size()];
+
+                // We already know (p_f, p_s) <= (c_f, c_s),
+                //   it's p_f < c_f || (p_f == c_f && p_s <= c_s)
+                // We just they are not equal we just need to
+                //   check p_f < c_f || p_s < c_s, because if
+                //   p_f < c_f is not true, p_f >= c_f,
+                //   then p_f == c_f.
+                if (prev_item_first_half_comp < cur_item_first_half_comp || prev_item_second_half_comp < cur_item_second_half_comp) {
+                    new_component_by_item[cur_item] = new_component_by_item[prev_item] + 1;
+                } else {
+                    new_component_by_item[cur_item] = new_component_by_item[prev_item];
+                }
+            }
+            // Массив новых компонент переходит в следующую итерацию,
+            //   а предыдущий используем как временную память.
+            //   Мы её перезапишем.
+            // А массив отсортированного порядка мы поменяли ещё
+            //   при сортировке по первой половине.
+            std::swap(new_component_by_item, component_by_item);
+        }
+        // Все компоненты различны: дальше порядок не меняется.
+        if (component_by_item[sorted_items.back()] + 1 == text_mod.size()) {
+            break;
+        }
+    }
+    // После всех итераций отсортировали по большому количеству символов (>= n),
+    //   по факту получили сортировку суффиксов.
+    // Только удалим символ ноль, он лежит первым, т.к. это самый маленький
+    //   суффикс.
+    //   TODO: добавить в шаги, указать здесь шаг, как выше.
+    suffix_array.assign(sorted_items.begin() + 1, sorted_items.end());
+    // После всех итераций размер каждой компоненты равен одному,
+    //   т.к. все элементы различны. И это просто индекс суффикса
+    //   в суффиксном массиве (обратный суффиксный массив).
+    //   TODO: добавить в шаги, указать здесь шаг, как выше.
+    //   TODO: указать, зачем обратный суффиксный массив и в шаге, и тут: для lcp.
+    // Только нужно удалить компоненту по item-у text.size(), т.к это нулевой символ.
+    //   И все компоненты сдвинуть на один, т.к. первая компонента -- компонента
+    //   нулевого символа.
+    inv_suffix_array.resize(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        inv_suffix_array[i] = static_cast<Index>(component_by_item[i] - 1);
+    }
+}
+
+// Строки короче этой строятся SA-IS в одном потоке: запуск
+//   потоков на каждом проходе удвоения дороже самой сортировки.
+constexpr size_t kParallelSuffixArrayMinSize = 1 << 16;
+// Цифра поразрядной сортировки: счётчики блока -- 8 Кб,
+//   помещаются в L1.
+constexpr int kRadixBits = 11;
+constexpr size_t kRadixSize = static_cast<size_t>(1) << kRadixBits;
+
+// Суффиксный массив на num_threads потоках алгоритмом
+//   Манбера-Майерса. У SA-IS проходы индуцированной сортировки
+//   по своей природе последовательны, а удвоение делится на
+//   блоки. Последовательная версия на каждой итерации
+//   сортирует подсчётом по номеру компоненты, и счётчиков на
+//   каждый поток там понадобилось бы n. Здесь пара компонент
+//   (первая половина, вторая) упаковывается в 64-битный ключ
+//   и сортируется поразрядно цифрами по kRadixBits бит: у
+//   каждого потока свои счётчики для своего блока, смещения
+//   блоков -- префиксные суммы по цифре, затем по блокам. Так
+//   каждый поток раскладывает свой блок, и сортировка остаётся
+//   устойчивой. Новые номера компонент -- префиксные суммы
+//   признаков "ключ не равен предыдущему", тоже по блокам.
+// Позиции 32-битные, строка с дописанным символом должна быть
+//   короче 4 Гб. suffix_array -- text.size() элементов.
+template<typename Char>
+void prefix_doubling_parallel(std::span<const Char> text, std::span<uint32_t> suffix_array, Workspace& workspace, size_t num_threads) {
+    WorkspaceScope scope(workspace);
+    const size_t size = text.size() + 1;
+    assert(size < std::numeric_limits<uint32_t>::max());
+    const size_t num_blocks = num_threads;
+    auto block_begin = [&](size_t block) {
+        return block * size / num_blocks;
+    };
+
+    // Начальные компоненты -- сами символы, сдвинутые на один;
+    //   дописанный ноль меньше всех. Плотными они станут после
+    //   первой итерации, а пока нужно, чтобы они помещались в
+    //   component_bits.
+    std::span<uint32_t> component_by_item = workspace.allocate<uint32_t>(size);
+    size_t max_component = size - 1;
+    for (size_t i = 0; i < text.size(); ++i) {
+        component_by_item[i] = static_cast<uint32_t>(text[i]) + 1;
+        max_component = std::max<size_t>(max_component, component_by_item[i]);
+    }
+    component_by_item[text.size()] = 0;
+    const int component_bits = std::bit_width(max_component);
+    const int key_bits = 2 * component_bits;
+
+    std::span<uint64_t> keys = workspace.allocate<uint64_t>(size);
+    std::span<uint64_t> new_keys = workspace.allocate<uint64_t>(size);
+    std::span<uint32_t> sorted_items = workspace.allocate<uint32_t>(size);
+    std::span<uint32_t> new_sorted_items = workspace.allocate<uint32_t>(size);
+    // Счётчики цифр по блокам, потом -- смещения.
+    std::span<uint32_t> num_occurs = workspace.allocate<uint32_t>(num_blocks * kRadixSize);
+    // Число новых компонент, начинающихся в блоке.
+    std::span<uint32_t> num_block_starts = workspace.allocate<uint32_t>(num_blocks);
+
+    for (size_t half_len = 1;; half_len *= 2) {
+        Stats::global().add(Counter::kDoublingRounds);
+        parallel_for(num_blocks, num_threads, [&](size_t block, size_t) {
+            for (size_t i = block_begin(block); i < block_begin(block + 1); ++i) {
+                const size_t second = (i + half_len) % size;
+                keys[i] = (static_cast<uint64_t>(component_by_item[i]) << component_bits) | component_by_item[second];
+                sorted_items[i] = static_cast<uint32_t>(i);
+            }
+        });
+
+        for (int shift = 0; shift < key_bits; shift += kRadixBits) {
+            auto digit_of = [&](uint64_t key) {
+                return static_cast<size_t>(key >> shift) & (kRadixSize - 1);
+            };
+            parallel_for(num_blocks, num_threads, [&](size_t block, size_t) {
+                std::span<uint32_t> counts = num_occurs.subspan(block * kRadixSize, kRadixSize);
+                std::fill(counts.begin(), counts.end(), 0);
+                for (size_t i = block_begin(block); i < block_begin(block + 1); ++i) {
+                    counts[digit_of(keys[i])] += 1;
+                }
+            });
+            // Исключающие префиксные суммы: по цифре, внутри
+            //   цифры -- по блокам, чтобы блоки шли по порядку.
+            size_t num_items_before = 0;
+            for (size_t digit = 0; digit < kRadixSize; ++digit) {
+                for (size_t block = 0; block < num_blocks; ++block) {
+                    uint32_t& count = num_occurs[block * kRadixSize + digit];
+                    const size_t num_occurences = count;
+                    count = static_cast<uint32_t>(num_items_before);
+                    num_items_before += num_occurences;
+                }
+            }
+            parallel_for(num_blocks, num_threads, [&](size_t block, size_t) {
+                std::span<uint32_t> offsets = num_occurs.subspan(block * kRadixSize, kRadixSize);
+                for (size_t i = block_begin(block); i < block_begin(block + 1); ++i) {
+                    const uint32_t pos = offsets[digit_of(keys[i])]++;
+                    new_keys[pos] = keys[i];
+                    new_sorted_items[pos] = sorted_items[i];
+                }
+            });
+            std::swap(keys, new_keys);
+            std::swap(sorted_items, new_sorted_items);
+        }
+
+        // Номер компоненты -- сколько различных ключей до этого.
+        parallel_for(num_blocks, num_threads, [&](size_t block, size_t) {
+            uint32_t num_starts = 0;
+            for (size_t i = std::max<size_t>(block_begin(block), 1); i < block_begin(block + 1); ++i) {
+                num_starts += keys[i] != keys[i - 1];
+            }
+            num_block_starts[block] = num_starts;
+        });
+        uint32_t num_components_before = 0;
+        for (size_t block = 0; block < num_blocks; ++block) {
+            const uint32_t num_starts = num_block_starts[block];
+            num_block_starts[block] = num_components_before;
+            num_components_before += num_starts;
+        }
+        parallel_for(num_blocks, num_threads, [&](size_t block, size_t) {
+            uint32_t component = num_block_starts[block];
+            for (size_t i = block_begin(block); i < block_begin(block + 1); ++i) {
+                component += i != 0 && keys[i] != keys[i - 1];
+                component_by_item[sorted_items[i]] = component;
+            }
+        });
+        // Все компоненты различны: дальше порядок не меняется.
+        if (num_components_before + 1 == size) {
+            break;
+        }
+    }
+
+    // Первым стоит дописанный ноль.
+    std::copy(sorted_items.begin() + 1, sorted_items.end(), suffix_array.begin());
+}
+
+template<typename Index, typename Char>
+void get_suffix_array_prefix_doubling_impl(std::span<const Char> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace) {
+    assert(text.size() < std::numeric_limits<Index>::max());
+    PhaseTimer timer(Phase::kSuffixArray, text.size());
+    // К строке дописывается символ, и позиция text.size() тоже
+    //   должна помещаться.
+    const bool fits_uint32 = text.size() + 1 < std::numeric_limits<uint32_t>::max();
+    if (fits_uint32) {
+        prefix_doubling<uint32_t, Index, Char>(text, suffix_array, inv_suffix_array, workspace);
+    } else {
+        prefix_doubling<uint64_t, Index, Char>(text, suffix_array, inv_suffix_array, workspace);
+    }
+}
+
+template<typename Index, typename Char>
+std::vector<Index> calculate_lcp_impl(std::span<const Char> text, const std::vector<Index>& suffix_array, const std::vector<Index>& inv_suffix_array) {
+    assert(!text.empty());
+    PhaseTimer timer(Phase::kLcp, text.size());
+
+    // Алгоритм Аримуры-Арикавы-Касаи-Ли-Парка
+    //   построение массива lcp для суффиксного
+    //   массива.
+    // Пусть sa -- суффиксный массив,
+    //   isa    -- обратный суффиксный массив
+    //     (по номеру суффикса позиция в
+    //      суффиксном массиве),
+    //   text   -- текст.
+    // Основное утверждение:
+    //   lcp[isa[i + 1]] >= lcp[isa[i]] - 1.
+    //   Возьмём суффикс, у которого есть следующий в суффиксном массиве.
+    //   У него есть какой-то lcp с предыдущим суффиксом в суффиксном массиве.
+    //   Если lcp с предыдущим символом равен нулю, то получаем неравенство
+    //   lcp[*] >= -1, что всегда верно, ведь lcp не отрицателен.
+    //   Если lcp с предыдущим символом как минимум один, то удалим их общий
+    //   первый символ. Получим два суффикса, которые так же упорядочены:
+    //   предыдущий суффикс был меньше текущего, т.е. в первой несовпадающей
+    //   позиции он меньше, или совпадает во всех, но длина меньше (суффиксы
+    //   с разным началом никогда не равны, т.к. у них как минимум разные
+    //   длины, если даже все символы совпадают). Тогда после удаления
+    //   первого совпадающего символа сравнение такое же. Наидлиннейший
+    //   отрезок совпадающих первых символов сдвинулся на один символ, его
+    //   длина уменьшилась на один символ. Значит, lcp между этими двумя
+    //   отрезками ровно lcp[isa[i]] - 1. Но они могли быть не соседними:
+    //   просто предположим, что не соседние, тогда допишем символ, к этим
+    //   двум суффиксам можем дописать, а возможно, что к суффиксу между
+    //   ними не можем дописать этот символ, там другой. Не смогли доказать,
+    //   и реально такой пример может быть. Потому просто есть неравенство,
+    //   что сколько-то длины lcp у нас уже есть.
+    // Лучше объяснено тут: https://www.youtube.com/watch?v=s68lnO3yEKY&list=PLtb_PNVHdsV7QlpdH1XmsqqF9AxYRQpWY&index=19
+    // А теперь как сделать алгоритм? Будем двигаться от самых длинных
+    //   суффиксов к коротким (т.е. просто от начала строки к концу,
+    //   перебирать начало суффикса в строке). Для коротких у нас уже
+    //   будет неравенство от их продолжений, что сколько-то lcp у них
+    //   есть, это похоже на z-функцию. Можно попробовать увеличить.
+    //   Переход к следующему суффиксу и есть удаление первого символа,
+    //   потому lcp -- просто переменная между итерациями.
+    // За сколько это работает? Каждую итерацию убывает на один,
+    //   увеличивается на много, но сама величина 0 <= lcp <= |t|.
+    // Амортизационный анализ. Итерации связаны с изменением некоторой
+    //   величины, на которую есть оценка. Пусть n_i -- количество
+    //   итераций while с попыткой увеличить lcp.
+    //   TODO: написать, мб к экзамену. Кажется, сейчас уже нет смысла,
+    //   стало понятно. n_i = lcp_i - lcp_{i - 1}...
+    //   sum (C1 + C2 n_i) <= C_1 * n + C_2 * (lcp_{n} - lcp_0) <= C n
+    // Только тут ещё есть проблема, как мы обходим случай, когда
+    //   встречаем суффикс, который первый в суффиксном массиве? Тогда
+    //   либо на предыдущей итерации был lcp = 0, тогда мы просто
+    //   наивно посчитаем, всё ок так же по амортизированному анализу.
+    //   Либо предыдущий в СА суффикс на предыдущей итерации был из
+    //   одного символа. Иначе lcp > 0, у нас был предыдущий суффикс
+    //   в СА, а после удаления символа нет, тогда получился пустой
+    //   суффикс просто там, если там длина хотя бы два, то суффикс
+    //   меньше будет. lcp = 1 на прошлой итерации, на этой оценка
+    //   снизу ноль. Посчитаем явно на следующей, всё ок.
+
+    std::vector<Index> result(text.size() - 1, 0);
+    size_t lcp_lower_bound = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        size_t sa_pos = inv_suffix_array[i];
+        if (sa_pos == 0) {
+            continue;
+        }
+
+        size_t sa_prev_suffix = suffix_array[sa_pos - 1];
+
+        size_t lcp = lcp_lower_bound;
+        size_t cur_suffix_len = text.size() - i;
+        size_t sa_prev_suffix_len = text.size() - sa_prev_suffix;
+        if (lcp < cur_suffix_len && lcp < sa_prev_suffix_len) {
+            lcp += common_prefix_len(text.data() + sa_prev_suffix + lcp, text.data() + i + lcp, std::min(cur_suffix_len, sa_prev_suffix_len) - lcp);
+        }
+
+        // В массиве lcp индекс -- индекс суффикса в суффиксном массиве,
+        //   значение -- длина наидлиннейшего общий префикса со
+        //   следующим, а мы для каждой пары соседних в суффиксном
+        //   массиве перебирали второго из пары, потому надо уменьшить.
+        // То же самое получается, если в lcp хранить длину наидлиннейшего
+        //   общий префикса с предыдущим.
+        result[sa_pos - 1] = static_cast<Index>(lcp);
+
+        // Без нижней оценки на lcp, т.е. без того утверждения (леммы Касаи)
+        //   если выполнять, количество итераций while наверху не соответстует
+        //   изменению lcp, поскольку мы заново начинаем с 0, а с оценкой снизу
+        //   начинаем с почти предыдущего значения.
+        if (lcp == 0) {
+            lcp_lower_bound = 0;
+        } else {
+            lcp_lower_bound = lcp - 1;
+        }
+    }
+
+    return result;
+}
+
+// Алгоритм SA-IS (Нонг, Жанг, Чан), построение суффиксного
+//   массива за O(n). Реализация по мотивам AtCoder Library.
+// Суффиксы делятся на S-типа (суффикс меньше следующего) и
+//   L-типа (больше следующего). LMS-суффикс -- суффикс S-типа,
+//   перед которым L-типа. Если LMS-суффиксы отсортированы, то
+//   остальные суффиксы расставляются по корзинам первых символов
+//   двумя проходами индуцированной сортировки: L-типа слева
+//   направо, S-типа справа налево.
+//   Чтобы отсортировать LMS-суффиксы, сначала индуцированной
+//   сортировкой упорядочиваем LMS-подстроки (от LMS-позиции до
+//   следующей), даём им имена и рекурсивно строим суффиксный
+//   массив строки из имён. Она хотя бы в два раза короче.
+// Index -- тип для позиций: uint32_t, если строка короче 4 Гб,
+//   иначе uint64_t. Массивы позиций -- основная память алгоритма,
+//   32-битные индексы уменьшают её в два раза.
+// Неявный конечный символ меньше всех остальных, дописывать
+//   его не надо. upper -- наибольший символ строки.
+// Временные массивы берутся из workspace и возвращаются в него
+//   при выходе, sa -- результат, размера text.size().
+template<typename Index, typename Char>
+void sa_is(std::span<const Char> text, size_t upper, std::span<Index> sa, Workspace& workspace) {
+    constexpr Index kEmpty = std::numeric_limits<Index>::max();
+    const size_t n = text.size();
+    assert(sa.size() == n);
+    if (n == 0) {
+        return;
+    }
+    if (n == 1) {
+        sa[0] = 0;
+        return;
+    }
+    if (n == 2) {
+        if (text[0] < text[1]) {
+            sa[0] = 0;
+            sa[1] = 1;
+        } else {
+            sa[0] = 1;
+            sa[1] = 0;
+        }
+        return;
+    }
+
+    Stats::global().add(Counter::kSaIsLevels);
+
+    // is_s_type[i] -- суффикс i S-типа. Последний суффикс L-типа:
+    //   за ним неявный наименьший символ. Суффикс S-типа не может
+    //   начинаться с наибольшего символа, потому ниже c + 1 <= upper.
+    //   Храним по биту на суффикс.
+    WorkspaceScope scope(workspace);
+    std::span<uint64_t> is_s_type_bits = workspace.allocate<uint64_t>((n + 63) / 64);
+    std::fill(is_s_type_bits.begin(), is_s_type_bits.end(), 0);
+    auto is_s_type = [&](size_t i) {
+        return ((is_s_type_bits[i / 64] >> (i % 64)) & 1) != 0;
+    };
+    for (size_t i = n - 1; i-- > 0;) {
+        bool s_type = text[i] == text[i + 1] ? is_s_type(i + 1) : text[i] < text[i + 1];
+        is_s_type_bits[i / 64] |= static_cast<uint64_t>(s_type) << (i % 64);
+    }
+
+    // Корзина символа c: сначала суффиксы L-типа, потом S-типа.
+    //   sum_l[c] -- начало L-части корзины, sum_s[c] -- начало S-части.
+    std::span<Index> sum_l = workspace.allocate<Index>(upper + 1);
+    std::span<Index> sum_s = workspace.allocate<Index>(upper + 1);
+    std::fill(sum_l.begin(), sum_l.end(), 0);
+    std::fill(sum_s.begin(), sum_s.end(), 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (!is_s_type(i)) {
+            sum_s[text[i]] += 1;
+        } else {
+            sum_l[text[i] + 1] += 1;
+        }
+    }
+    for (size_t c = 0; c <= upper; ++c) {
+        sum_s[c] += sum_l[c];
+        if (c < upper) {
+            sum_l[c + 1] += sum_s[c];
+        }
+    }
+
+    std::span<Index> bucket = workspace.allocate<Index>(upper + 1);
+    auto induce = [&](std::span<const Index> lms) {
+        std::fill(sa.begin(), sa.end(), kEmpty);
+        // LMS-суффиксы в S-части корзин в заданном порядке.
+        std::copy(sum_s.begin(), sum_s.end(), bucket.begin());
+        for (Index pos: lms) {
+            sa[bucket[text[pos]]++] = pos;
+        }
+        // Суффиксы L-типа слева направо. Последний суффикс
+        //   L-типа и меньше всех в своей корзине.
+        std::copy(sum_l.begin(), sum_l.end(), bucket.begin());
+        sa[bucket[text[n - 1]]++] = static_cast<Index>(n - 1);
+        for (size_t i = 0; i < n; ++i) {
+            Index pos = sa[i];
+            if (pos != kEmpty && pos >= 1 && !is_s_type(pos - 1)) {
+                sa[bucket[text[pos - 1]]++] = pos - 1;
+            }
+        }
+        // Суффиксы S-типа справа налево, с конца корзин. Конец
+        //   корзины c -- начало L-части корзины c + 1.
+        std::copy(sum_l.begin(), sum_l.end(), bucket.begin());
+        for (size_t i = n; i-- > 0;) {
+            Index pos = sa[i];
+            if (pos != kEmpty && pos >= 1 && is_s_type(pos - 1)) {
+                sa[--bucket[text[pos - 1] + 1]] = pos - 1;
+            }
+        }
+    };
+
+    // lms_index[i] -- номер LMS-суффикса i среди всех LMS-суффиксов.
+    std::span<Index> lms_index = workspace.allocate<Index>(n + 1);
+    std::fill(lms_index.begin(), lms_index.end(), kEmpty);
+    size_t num_lms = 0;
+    for (size_t i = 1; i < n; ++i) {
+        if (!is_s_type(i - 1) && is_s_type(i)) {
+            lms_index[i] = static_cast<Index>(num_lms);
+            ++num_lms;
+        }
+    }
+    std::span<Index> lms = workspace.allocate<Index>(num_lms);
+    for (size_t i = 1; i < n; ++i) {
+        if (lms_index[i] != kEmpty) {
+            lms[lms_index[i]] = static_cast<Index>(i);
+        }
+    }
+
+    // Первая индуцированная сортировка упорядочивает LMS-подстроки.
+    induce(lms);
+    if (num_lms == 0) {
+        return;
+    }
+
+    std::span<Index> sorted_lms = workspace.allocate<Index>(num_lms);
+    size_t num_sorted_lms = 0;
+    for (Index pos: sa) {
+        if (lms_index[pos] != kEmpty) {
+            sorted_lms[num_sorted_lms++] = pos;
+        }
+    }
+
+    // Имена LMS-подстрок: равные подстроки получают равные имена,
+    //   порядок имён совпадает с порядком подстрок.
+    std::span<Index> reduced = workspace.allocate<Index>(num_lms);
+    size_t reduced_upper = 0;
+    reduced[lms_index[sorted_lms[0]]] = 0;
+    for (size_t i = 1; i < num_lms; ++i) {
+        size_t left = sorted_lms[i - 1];
+        size_t right = sorted_lms[i];
+        const size_t left_end  = lms_index[left]  + 1 < num_lms ? lms[lms_index[left]  + 1] : n;
+        const size_t right_end = lms_index[right] + 1 < num_lms ? lms[lms_index[right] + 1] : n;
+        bool same = true;
+        if (left_end - left != right_end - right) {
+            same = false;
+        } else {
+            while (left < left_end && text[left] == text[right]) {
+                ++left;
+                ++right;
+            }
+            if (left == n || text[left] != text[right]) {
+                same = false;
+            }
+        }
+        if (!same) {
+            ++reduced_upper;
+        }
+        reduced[lms_index[sorted_lms[i]]] = static_cast<Index>(reduced_upper);
+    }
+
+    // Порядок суффиксов строки имён -- порядок LMS-суффиксов.
+    std::span<Index> reduced_sa = workspace.allocate<Index>(num_lms);
+    sa_is<Index, Index>(reduced, reduced_upper, reduced_sa, workspace);
+    for (size_t i = 0; i < num_lms; ++i) {
+        sorted_lms[i] = lms[reduced_sa[i]];
+    }
+    induce(sorted_lms);
+}
+
+template<typename Index, typename Char>
+void get_suffix_array_impl(std::span<const Char> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace, size_t num_threads = 1) {
+    assert(!text.empty());
+    assert(text.size() < std::numeric_limits<Index>::max());
+    PhaseTimer timer(Phase::kSuffixArray, text.size());
+    WorkspaceScope scope(workspace);
+
+    const size_t upper = *std::max_element(text.begin(), text.end());
+    if (text.size() < std::numeric_limits<uint32_t>::max()) {
+        std::span<uint32_t> sa = workspace.allocate<uint32_t>(text.size());
+        // Удвоение дописывает к строке символ, его позиция тоже
+        //   должна поместиться в 32 бита.
+        if (num_threads > 1 && text.size() >= kParallelSuffixArrayMinSize && text.size() + 1 < std::numeric_limits<uint32_t>::max()) {
+            prefix_doubling_parallel<Char>(text, sa, workspace, num_threads);
+        } else {
+            sa_is<uint32_t, Char>(text, upper, sa, workspace);
+        }
+        suffix_array.assign(sa.begin(), sa.end());
+    } else {
+        std::span<uint64_t> sa = workspace.allocate<uint64_t>(text.size());
+        sa_is<uint64_t, Char>(text, upper, sa, workspace);
+        suffix_array.assign(sa.begin(), sa.end());
+    }
+
+    inv_suffix_array.resize(text.size());
+    for (size_t i = 0; i < suffix_array.size(); ++i) {
+        inv_suffix_array[suffix_array[i]] = static_cast<Index>(i);
+    }
+}
+
+// Массив PLCP по Φ-алгоритму (Кярккяйнен, Манзини, Пуглиси):
+//   plcp[i] -- lcp суффикса i с предыдущим в суффиксном массиве.
+//   Это те же значения, что у Касаи, только в порядке текста.
+//   Φ[i] -- предыдущий в суффиксном массиве суффикс, храним его
+//   в том же массиве: на шаге i нужен только Φ[i], и после шага
+//   он заменяется на plcp[i]. Текст и массив читаются
+//   последовательно, случайное обращение одно на шаг: text[Φ[i]].
+//   Обратный суффиксный массив не нужен.
+// На сколько символов продолжается общий префикс суффиксов
+//   first и second, о котором известно, что он не короче known.
+template<typename Char>
+size_t extend_match(std::span<const Char> text, size_t first, size_t second, size_t known) {
+    const size_t limit = text.size() - std::max(first, second);
+    if (known >= limit) {
+        return 0;
+    }
+    return common_prefix_len(text.data() + first + known, text.data() + second + known, limit - known);
+}
+
+template<typename Index, typename Char>
+void calculate_plcp(std::span<const Char> text, std::span<const Index> suffix_array, std::vector<Index>& plcp) {
+    constexpr Index kNone = std::numeric_limits<Index>::max();
+    const size_t n = text.size();
+    std::vector<Index>& phi = plcp;
+    phi.resize(n);
+    phi[suffix_array[0]] = kNone;
+    for (size_t i = 1; i < n; ++i) {
+        phi[suffix_array[i]] = suffix_array[i - 1];
+    }
+
+    size_t lcp = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Index prev = phi[i];
+        if (prev == kNone) {
+            plcp[i] = 0;
+            lcp = 0;
+            continue;
+        }
+        // Та же нижняя оценка, что у Касаи: plcp[i] >= plcp[i - 1] - 1.
+        lcp += extend_match(text, i, prev, lcp);
+        plcp[i] = static_cast<Index>(lcp);
+        if (lcp > 0) {
+            lcp -= 1;
+        }
+    }
+}
+
+// Наидлиннейшая общая подстрока по суффиксному массиву строки
+//   first + разделитель + second. Нужны только lcp соседних в
+//   суффиксном массиве суффиксов из разных строк, потому PLCP
+//   целиком не храним: в порядке текста считаем lcp с Φ[i] и
+//   учитываем, только если i и Φ[i] из разных строк.
+template<typename Index, typename Char>
+size_t longest_cmn_substr_len_phi(std::span<const Char> text, size_t first_size, std::span<const Index> suffix_array, std::span<Index> phi) {
+    constexpr Index kNone = std::numeric_limits<Index>::max();
+    const size_t n = text.size();
+    assert(phi.size() == n);
+    phi[suffix_array[0]] = kNone;
+    for (size_t i = 1; i < n; ++i) {
+        phi[suffix_array[i]] = suffix_array[i - 1];
+    }
+
+    size_t result = 0;
+    size_t lcp = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Index prev = phi[i];
+        if (prev == kNone) {
+            lcp = 0;
+            continue;
+        }
+        lcp += extend_match(text, i, prev, lcp);
+        if ((i < first_size) != (prev < first_size)) {
+            result = std::max(result, lcp);
+        }
+        if (lcp > 0) {
+            lcp -= 1;
+        }
+    }
+    return result;
+}
+
+template<typename Index>
+size_t get_longest_cmn_substr_len_impl(std::span<const uint16_t> joined, size_t first_size, Workspace& workspace, size_t num_threads) {
+    WorkspaceScope scope(workspace);
+    std::span<Index> suffix_array = workspace.allocate<Index>(joined.size());
+    {
+        PhaseTimer timer(Phase::kSuffixArray, joined.size());
+        bool built = false;
+        if constexpr (std::is_same_v<Index, uint32_t>) {
+            if (num_threads > 1 && joined.size() >= kParallelSuffixArrayMinSize && joined.size() + 1 < std::numeric_limits<uint32_t>::max()) {
+                prefix_doubling_parallel<uint16_t>(joined, suffix_array, workspace, num_threads);
+                built = true;
+            }
+        }
+        if (!built) {
+            sa_is<Index, uint16_t>(joined, 255 + 1, suffix_array, workspace);
+        }
+    }
+    // Временные массивы построения уже возвращены, Φ займёт их место.
+    std::span<Index> phi = workspace.allocate<Index>(joined.size());
+    PhaseTimer timer(Phase::kLcp, joined.size());
+    return longest_cmn_substr_len_phi<Index, uint16_t>(joined, first_size, suffix_array, phi);
+}
+
+template<typename Index, typename Char>
+void calculate_lcp_phi_impl(std::span<const Char> text, const std::vector<Index>& suffix_array, std::vector<Index>& lcp, std::vector<Index>& plcp) {
+    assert(!text.empty());
+    PhaseTimer timer(Phase::kLcp, text.size());
+    calculate_plcp<Index, Char>(text, suffix_array, plcp);
+    lcp.resize(text.size() - 1);
+    for (size_t i = 0; i + 1 < suffix_array.size(); ++i) {
+        lcp[i] = plcp[suffix_array[i + 1]];
+    }
+}
+
+}
+
+template<typename Index>
+void get_suffix_array(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace) {
+    get_suffix_array_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace) {
+    get_suffix_array_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace, size_t num_threads) {
+    get_suffix_array_impl(text, suffix_array, inv_suffix_array, workspace, num_threads);
+}
+
+template<typename Index>
+void get_suffix_array(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace, size_t num_threads) {
+    get_suffix_array_impl(text, suffix_array, inv_suffix_array, workspace, num_threads);
+}
+
+template<typename Index>
+void get_suffix_array(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array) {
+    Workspace workspace;
+    get_suffix_array_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array) {
+    Workspace workspace;
+    get_suffix_array_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace) {
+    get_suffix_array_prefix_doubling_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace) {
+    get_suffix_array_prefix_doubling_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array) {
+    Workspace workspace;
+    get_suffix_array_prefix_doubling_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array) {
+    Workspace workspace;
+    get_suffix_array_prefix_doubling_impl(text, suffix_array, inv_suffix_array, workspace);
+}
+
+template<typename Index>
+std::vector<Index> calculate_lcp(std::span<const uint8_t> text, const std::vector<Index>& suffix_array, const std::vector<Index>& inv_suffix_array) {
+    return calculate_lcp_impl(text, suffix_array, inv_suffix_array);
+}
+
+template<typename Index>
+std::vector<Index> calculate_lcp(std::span<const uint16_t> text, const std::vector<Index>& suffix_array, const std::vector<Index>& inv_suffix_array) {
+    return calculate_lcp_impl(text, suffix_array, inv_suffix_array);
+}
+
+template<typename Index>
+void calculate_lcp(std::span<const uint8_t> text, const std::vector<Index>& suffix_array, std::vector<Index>& lcp, std::vector<Index>& plcp) {
+    calculate_lcp_phi_impl(text, suffix_array, lcp, plcp);
+}
+
+template<typename Index>
+void calculate_lcp(std::span<const uint16_t> text, const std::vector<Index>& suffix_array, std::vector<Index>& lcp, std::vector<Index>& plcp) {
+    calculate_lcp_phi_impl(text, suffix_array, lcp, plcp);
+}
+
+// Версии для обеих ширин позиций.
+#define INSTANTIATE_SUFFIX_ARRAY(Index, Char) \
+    template void get_suffix_array<Index>(std::span<const Char>, std::vector<Index>&, std::vector<Index>&, Workspace&); \
+    template void get_suffix_array<Index>(std::span<const Char>, std::vector<Index>&, std::vector<Index>&, Workspace&, size_t); \
+    template void get_suffix_array<Index>(std::span<const Char>, std::vector<Index>&, std::vector<Index>&); \
+    template void get_suffix_array_prefix_doubling<Index>(std::span<const Char>, std::vector<Index>&, std::vector<Index>&, Workspace&); \
+    template void get_suffix_array_prefix_doubling<Index>(std::span<const Char>, std::vector<Index>&, std::vector<Index>&); \
+    template std::vector<Index> calculate_lcp<Index>(std::span<const Char>, const std::vector<Index>&, const std::vector<Index>&); \
+    template void calculate_lcp<Index>(std::span<const Char>, const std::vector<Index>&, std::vector<Index>&, std::vector<Index>&);
+
+INSTANTIATE_SUFFIX_ARRAY(uint32_t, uint8_t)
+INSTANTIATE_SUFFIX_ARRAY(uint32_t, uint16_t)
+INSTANTIATE_SUFFIX_ARRAY(size_t, uint8_t)
+INSTANTIATE_SUFFIX_ARRAY(size_t, uint16_t)
+
+#undef INSTANTIATE_SUFFIX_ARRAY
+
+size_t estimate_lcs_workspace_bytes(size_t first_size, size_t second_size) {
+    // Склеенная строка по 2 байта на символ, суффиксный массив и
+    //   на месте временных массивов SA-IS -- Φ. Временные массивы
+    //   SA-IS: по биту на символ, номера LMS-позиций (n + 1), до
+    //   четырёх массивов по n / 2 для LMS-суффиксов, и то же на
+    //   строке вдвое короче в рекурсии. Оценка сверху, с запасом.
+    const size_t n = first_size + 1 + second_size;
+    const size_t index_size = n < std::numeric_limits<uint32_t>::max() ? sizeof(uint32_t) : sizeof(uint64_t);
+    return n * 2 + n * index_size + 2 * (n / 8 + (n + 1) * index_size + 2 * n * index_size) + 4096;
+}
+
+size_t estimate_lcs_workspace_bytes(size_t first_size, size_t second_size, size_t num_threads) {
+    const size_t n = first_size + 1 + second_size;
+    const size_t serial_bytes = estimate_lcs_workspace_bytes(first_size, second_size);
+    if (num_threads <= 1 || n < kParallelSuffixArrayMinSize || n + 1 >= std::numeric_limits<uint32_t>::max()) {
+        return serial_bytes;
+    }
+    // Удвоение на потоках: склеенная строка, суффиксный массив,
+    //   номера компонент, по два массива ключей и позиций и
+    //   счётчики цифр на каждый блок.
+    const size_t parallel_bytes = n * 2 + n * sizeof(uint32_t) + (n + 1) * (sizeof(uint32_t) + 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t)) + num_threads * (kRadixSize + 1) * sizeof(uint32_t) + 4096;
+    return std::max(serial_bytes, parallel_bytes);
+}
+
+size_t get_longest_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second) {
+    Workspace workspace;
+    return get_longest_cmn_substr_len(first, second, workspace);
+}
+
+size_t get_longest_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second, Workspace& workspace) {
+    return get_longest_cmn_substr_len(first, second, workspace, 1);
+}
+
+size_t get_longest_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second, Workspace& workspace, size_t num_threads) {
+    WorkspaceScope scope(workspace);
+
+    // Между строками ставим разделитель 256, которого нет ни в
+    //   одной из них. Без него общий префикс суффикса первой строки
+    //   с суффиксом второй мог продолжиться во вторую строку.
+    constexpr uint16_t kSeparator = 255 + 1;
+    std::span<uint16_t> joined = workspace.allocate<uint16_t>(first.size() + 1 + second.size());
+    std::copy(first.begin(), first.end(), joined.begin());
+    joined[first.size()] = kSeparator;
+    std::copy(second.begin(), second.end(), joined.begin() + first.size() + 1);
+
+    // Суффиксы совпадающих подстрок наибольшей длины находятся рядом
+    //   в суффиксном массиве. Суффикс, начинающийся с разделителя,
+    //   относим ко второй строке: его общий префикс с любым другим
+    //   суффиксом пустой.
+    // Позиции храним в 32 битах, когда строка это позволяет: массивы
+    //   позиций -- почти вся память и обращения к памяти.
+    if (joined.size() < std::numeric_limits<uint32_t>::max()) {
+        return get_longest_cmn_substr_len_impl<uint32_t>(joined, first.size(), workspace, num_threads);
+    }
+    return get_longest_cmn_substr_len_impl<uint64_t>(joined, first.size(), workspace, num_threads);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "workspace.hpp"
+
+// Суффиксный массив и обратный к нему (по началу суффикса
+//   его позиция в суффиксном массиве). Строится алгоритмом
+//   SA-IS за O(n).
+// Версии для uint16_t нужны для текстов с разделителями:
+//   к байтам добавляются символы больше 255.
+// Index -- тип позиций в результате, uint32_t или size_t.
+//   uint32_t вдвое меньше по памяти и подходит для текстов
+//   короче 4 Гб. Временные массивы 32-битные, когда текст это
+//   позволяет, независимо от Index.
+// Временные массивы берутся из workspace. Версии без него
+//   заводят свой на время вызова.
+template<typename Index>
+void get_suffix_array(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace);
+template<typename Index>
+void get_suffix_array(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace);
+template<typename Index>
+void get_suffix_array(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array);
+template<typename Index>
+void get_suffix_array(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array);
+
+// То же на num_threads потоках, с тем же результатом. Строки от
+//   64 Кб строятся удвоением Манбера-Майерса, сортировки в нём
+//   поразрядные со счётчиками на поток. Короткие строки, строки
+//   от 4 Гб и num_threads == 1 -- SA-IS в вызывающем потоке.
+template<typename Index>
+void get_suffix_array(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace, size_t num_threads);
+template<typename Index>
+void get_suffix_array(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace, size_t num_threads);
+
+// То же самое алгоритмом Манбера-Майерса за O(n log(n)).
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace);
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array, Workspace& workspace);
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint8_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array);
+template<typename Index>
+void get_suffix_array_prefix_doubling(std::span<const uint16_t> text, std::vector<Index>& suffix_array, std::vector<Index>& inv_suffix_array);
+
+// Массив lcp: lcp[i] -- длина наидлиннейшего общего префикса
+//   суффиксов suffix_array[i] и suffix_array[i + 1].
+template<typename Index>
+std::vector<Index> calculate_lcp(std::span<const uint8_t> text, const std::vector<Index>& suffix_array, const std::vector<Index>& inv_suffix_array);
+template<typename Index>
+std::vector<Index> calculate_lcp(std::span<const uint16_t> text, const std::vector<Index>& suffix_array, const std::vector<Index>& inv_suffix_array);
+
+// То же самое Φ-алгоритмом: текст обходится по порядку, а не
+//   по суффиксному массиву, обратный суффиксный массив не нужен.
+//   lcp и plcp -- буферы вызывающего, при повторных вызовах
+//   память не выделяется. plcp[i] -- lcp суффикса i с предыдущим
+//   в суффиксном массиве.
+template<typename Index>
+void calculate_lcp(std::span<const uint8_t> text, const std::vector<Index>& suffix_array, std::vector<Index>& lcp, std::vector<Index>& plcp);
+template<typename Index>
+void calculate_lcp(std::span<const uint16_t> text, const std::vector<Index>& suffix_array, std::vector<Index>& lcp, std::vector<Index>& plcp);
+
+// Длина наидлиннейшей общей подстроки двух строк через
+//   суффиксный массив их конкатенации. Позиции 32-битные, если
+//   конкатенация короче 4 Гб. С общим workspace на поток
+//   повторные вызовы не выделяют память из кучи.
+size_t get_longest_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second, Workspace& workspace);
+size_t get_longest_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second);
+// То же, суффиксный массив строится на num_threads потоках, как
+//   у get_suffix_array. Для пар, которые считаются, когда
+//   остальные потоки свободны.
+size_t get_longest_cmn_substr_len(std::span<const uint8_t> first, std::span<const uint8_t> second, Workspace& workspace, size_t num_threads);
+
+// Сколько памяти workspace нужно get_longest_cmn_substr_len для
+//   строк таких длин, чтобы обойтись без кучи. Оценка сверху.
+//   С num_threads -- для версии на потоках.
+size_t estimate_lcs_workspace_bytes(size_t first_size, size_t second_size);
+size_t estimate_lcs_workspace_bytes(size_t first_size, size_t second_size, size_t num_threads);
@@ -0,0 +1,171 @@
+#include "suffix_automaton.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "stats.hpp"
+
+SuffixAutomaton::SuffixAutomaton(std::span<const uint8_t> text): text_size_(text.size()) {
+    assert(text.size() < kMaxTextSize);
+    PhaseTimer timer(Phase::kSuffixAutomatonBuild, text.size());
+
+    // Оценки сверху на количество состояний и переходов. Память
+    //   только резервируется, страницы выделятся по мере записи.
+    states_.reserve(std::max<size_t>(2 * text.size(), 1));
+    edges_.reserve(3 * text.size());
+
+    // Из корня почти всегда есть переходы по большей части алфавита,
+    //   и при запросах в корень возвращаемся постоянно, потому у него
+    //   таблица сразу.
+    State root;
+    root.edges = new_table();
+    root.degree = kMaxListDegree + 1;
+    states_.push_back(root);
+
+    for (uint8_t chr: text) {
+        extend(chr);
+    }
+}
+
+size_t SuffixAutomaton::estimate_bytes(size_t text_size) {
+    // Резерв под состояния и переходы. Таблицы переходов есть
+    //   только у верхних состояний, на них кладём 16 байт на символ
+    //   и таблицу корня.
+    return text_size * (2 * sizeof(State) + 3 * sizeof(Edge) + 16) + 256 * sizeof(uint32_t);
+}
+
+uint32_t SuffixAutomaton::new_table() {
+    uint32_t table = static_cast<uint32_t>(tables_.size() / 256);
+    tables_.resize(tables_.size() + 256, kNone);
+    return table;
+}
+
+uint32_t* SuffixAutomaton::find_transition(uint32_t state, uint8_t chr) {
+    const State& data = states_[state];
+    if (data.degree > kMaxListDegree) {
+        uint32_t* slot = &tables_[static_cast<size_t>(data.edges) * 256 + chr];
+        return *slot == kNone ? nullptr : slot;
+    }
+    for (uint32_t edge = data.edges; edge != kNone; edge = edges_[edge].next) {
+        if (edges_[edge].chr == chr) {
+            return &edges_[edge].target;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t SuffixAutomaton::transition(uint32_t state, uint8_t chr) const {
+    const State& data = states_[state];
+    if (data.degree > kMaxListDegree) {
+        return tables_[static_cast<size_t>(data.edges) * 256 + chr];
+    }
+    for (uint32_t edge = data.edges; edge != kNone; edge = edges_[edge].next) {
+        if (edges_[edge].chr == chr) {
+            return edges_[edge].target;
+        }
+    }
+    return kNone;
+}
+
+void SuffixAutomaton::add_transition(uint32_t state, uint8_t chr, uint32_t target) {
+    State& data = states_[state];
+    data.degree += 1;
+    if (data.degree == kMaxListDegree + 1) {
+        // Список стал длинным, переносим его в таблицу. Старые
+        //   элементы списка остаются в edges_ неиспользованными.
+        uint32_t table = new_table();
+        for (uint32_t edge = data.edges; edge != kNone; edge = edges_[edge].next) {
+            tables_[static_cast<size_t>(table) * 256 + edges_[edge].chr] = edges_[edge].target;
+        }
+        data.edges = table;
+    }
+
+    if (data.degree > kMaxListDegree) {
+        tables_[static_cast<size_t>(data.edges) * 256 + chr] = target;
+    } else {
+        edges_.push_back(Edge{target, data.edges, chr});
+        data.edges = static_cast<uint32_t>(edges_.size() - 1);
+    }
+}
+
+void SuffixAutomaton::extend(uint8_t chr) {
+    // Классическое построение: добавляем состояние для всей
+    //   строки, проводим в него переходы по суффиксным ссылкам,
+    //   пока перехода по символу нет. Если наткнулись на переход
+    //   в состояние, где строки длиннее нужного, расщепляем его
+    //   клонированием.
+    uint32_t cur = static_cast<uint32_t>(states_.size());
+    states_.push_back(State{states_[last_].len + 1, kNone, kNone, 0});
+
+    uint32_t p = last_;
+    while (p != kNone && find_transition(p, chr) == nullptr) {
+        add_transition(p, chr, cur);
+        p = states_[p].link;
+    }
+
+    if (p == kNone) {
+        states_[cur].link = 0;
+    } else {
+        uint32_t q = transition(p, chr);
+        if (states_[p].len + 1 == states_[q].len) {
+            states_[cur].link = q;
+        } else {
+            uint32_t clone = static_cast<uint32_t>(states_.size());
+            states_.push_back(State{states_[p].len + 1, states_[q].link, kNone, 0});
+            if (states_[q].degree > kMaxListDegree) {
+                uint32_t table = new_table();
+                std::copy_n(tables_.begin() + static_cast<size_t>(states_[q].edges) * 256, 256, tables_.begin() + static_cast<size_t>(table) * 256);
+                states_[clone].edges = table;
+                states_[clone].degree = states_[q].degree;
+            } else {
+                for (uint32_t edge = states_[q].edges; edge != kNone; edge = edges_[edge].next) {
+                    add_transition(clone, edges_[edge].chr, edges_[edge].target);
+                }
+            }
+            while (p != kNone) {
+                uint32_t* slot = find_transition(p, chr);
+                if (slot == nullptr || *slot != q) {
+                    break;
+                }
+                *slot = clone;
+                p = states_[p].link;
+            }
+            states_[q].link = clone;
+            states_[cur].link = clone;
+        }
+    }
+
+    last_ = cur;
+}
+
+size_t SuffixAutomaton::longest_cmn_substr_len(std::span<const uint8_t> other) const {
+    // Идём по другой строке, поддерживая наидлиннейший суффикс
+    //   прочитанного, который является подстрокой текста: state --
+    //   его состояние, len -- его длина. Если перехода нет,
+    //   укорачиваем суффикс по суффиксным ссылкам.
+    PhaseTimer timer(Phase::kSuffixAutomatonQuery, other.size());
+    const size_t max_possible = std::min(text_size_, other.size());
+    size_t result = 0;
+    uint32_t state = 0;
+    size_t len = 0;
+    for (uint8_t chr: other) {
+        uint32_t next = transition(state, chr);
+        while (next == kNone && state != 0) {
+            state = states_[state].link;
+            len = states_[state].len;
+            next = transition(state, chr);
+        }
+        if (next == kNone) {
+            len = 0;
+        } else {
+            state = next;
+            len += 1;
+        }
+        result = std::max(result, len);
+        if (result == max_possible) {
+            // Длиннее общей подстроки не бывает.
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Суффиксный автомат строки. Строится один раз за O(n) и
+//   дальше отвечает на запросы о наидлиннейшей общей подстроке
+//   с любой другой строкой за O(длины другой строки), проходя
+//   по ней, как по бору в алгоритме Ахо-Корасик.
+// Это позволяет построить индекс для файла из второй директории
+//   один раз и сравнить с ним все файлы первой, вместо того
+//   чтобы строить суффиксный массив заново для каждой пары.
+// Номера состояний и переходов 32-битные: состояний не больше
+//   2n, переходов не больше 3n, потому строка должна быть
+//   короче 1 Гб.
+class SuffixAutomaton {
+public:
+    explicit SuffixAutomaton(std::span<const uint8_t> text);
+
+    // Строки длиннее этой автомат не принимает.
+    static constexpr size_t kMaxTextSize = static_cast<size_t>(1) << 30;
+
+    // Оценка памяти на автомат строки длины text_size, для
+    //   выбора пути с ограниченной памятью.
+    static size_t estimate_bytes(size_t text_size);
+
+    size_t longest_cmn_substr_len(std::span<const uint8_t> other) const;
+
+    size_t text_size() const {
+        return text_size_;
+    }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    // Пока переходов у состояния не больше этого, они хранятся
+    //   списком, потом -- таблицей на весь алфавит. Таблица
+    //   занимает 1 Кб, а состояний с таким числом переходов не
+    //   больше 3n / kMaxListDegree, потому в худшем случае это
+    //   64 байта на символ. На реальных данных таких состояний
+    //   мало: это верхние уровни автомата.
+    static constexpr uint32_t kMaxListDegree = 16;
+
+    struct State {
+        // Длина самой длинной строки, ведущей в состояние.
+        uint32_t len = 0;
+        // Суффиксная ссылка.
+        uint32_t link = kNone;
+        // Начало односвязного списка переходов или номер
+        //   таблицы переходов, если degree > kMaxListDegree.
+        uint32_t edges = kNone;
+        uint32_t degree = 0;
+    };
+
+    struct Edge {
+        uint32_t target = kNone;
+        uint32_t next = kNone;
+        uint8_t chr = 0;
+    };
+
+    // Ячейка, где хранится переход по символу, или nullptr.
+    //   Указатель действителен до следующего добавления перехода.
+    uint32_t* find_transition(uint32_t state, uint8_t chr);
+    uint32_t transition(uint32_t state, uint8_t chr) const;
+    void add_transition(uint32_t state, uint8_t chr, uint32_t target);
+    uint32_t new_table();
+    void extend(uint8_t chr);
+
+    std::vector<State> states_;
+    std::vector<Edge> edges_;
+    // Таблицы переходов по 256 элементов подряд.
+    std::vector<uint32_t> tables_;
+    uint32_t last_ = 0;
+    size_t text_size_ = 0;
+};
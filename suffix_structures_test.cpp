@@ -0,0 +1,236 @@
+// Сверяет суффиксные структуры и сравнение блоками с наивными
+//   версиями на случайных строках: суффиксный массив (SA-IS и
+//   удвоение) -- с сортировкой суффиксов, lcp (Касаи и Φ) -- с
+//   посимвольным сравнением соседей, наидлиннейшую общую
+//   подстроку (суффиксный массив и автомат) -- с перебором,
+//   common_prefix_len и common_suffix_len -- с циклом по байтам.
+// Строки из повторяющихся кусков над маленьким алфавитом дают
+//   глубокую рекурсию SA-IS, над большим -- состояния автомата с
+//   таблицами переходов. Длины для сравнения блоками переходят
+//   через границы 16 и 32 байт. Построение на потоках сверяется
+//   с построением в одном потоке.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "byte_compare.hpp"
+#include "suffix_array.hpp"
+#include "suffix_automaton.hpp"
+#include "workspace.hpp"
+
+namespace {
+    size_t num_failures = 0;
+
+    void check(bool ok, std::string_view what, size_t iteration) {
+        if (!ok) {
+            std::cerr << what << ": iteration " << iteration << '\n';
+            ++num_failures;
+        }
+    }
+
+    template<typename Char>
+    std::vector<size_t> naive_suffix_array(const std::vector<Char>& text) {
+        std::vector<size_t> suffix_array(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            suffix_array[i] = i;
+        }
+        std::sort(suffix_array.begin(), suffix_array.end(), [&](size_t lhs, size_t rhs) {
+            return std::lexicographical_compare(text.begin() + static_cast<std::ptrdiff_t>(lhs), text.end(), text.begin() + static_cast<std::ptrdiff_t>(rhs), text.end());
+        });
+        return suffix_array;
+    }
+
+    template<typename Char>
+    std::vector<size_t> naive_lcp(const std::vector<Char>& text, const std::vector<size_t>& suffix_array) {
+        std::vector<size_t> lcp;
+        for (size_t i = 0; i + 1 < suffix_array.size(); ++i) {
+            size_t len = 0;
+            while (suffix_array[i] + len < text.size() && suffix_array[i + 1] + len < text.size() && text[suffix_array[i] + len] == text[suffix_array[i + 1] + len]) {
+                ++len;
+            }
+            lcp.push_back(len);
+        }
+        return lcp;
+    }
+
+    // Динамика по парам позиций: длина общего суффикса префиксов.
+    size_t brute_force_lcs_len(const std::vector<uint8_t>& first, const std::vector<uint8_t>& second) {
+        std::vector<size_t> previous(second.size() + 1, 0);
+        std::vector<size_t> current(second.size() + 1, 0);
+        size_t result = 0;
+        for (size_t i = 1; i <= first.size(); ++i) {
+            for (size_t j = 1; j <= second.size(); ++j) {
+                current[j] = first[i - 1] == second[j - 1] ? previous[j - 1] + 1 : 0;
+                result = std::max(result, current[j]);
+            }
+            std::swap(previous, current);
+        }
+        return result;
+    }
+
+    // Случайные символы или повторы уже написанных кусков, чтобы
+    //   были длинные одинаковые подстроки.
+    template<typename Char>
+    std::vector<Char> make_string(size_t size, size_t alphabet_size, std::mt19937_64& rng) {
+        std::vector<Char> data;
+        data.reserve(size);
+        while (data.size() < size) {
+            if (!data.empty() && rng() % 3 == 0) {
+                const size_t begin = rng() % data.size();
+                const size_t len = std::min<size_t>(1 + rng() % (data.size() - begin), size - data.size());
+                for (size_t i = 0; i < len; ++i) {
+                    data.push_back(data[begin + i]);
+                }
+            } else {
+                data.push_back(static_cast<Char>(rng() % alphabet_size));
+            }
+        }
+        return data;
+    }
+
+    template<typename Index, typename Char>
+    void check_suffix_array(const std::vector<Char>& text, Workspace& workspace, size_t iteration) {
+        const std::vector<size_t> expected = naive_suffix_array(text);
+        const std::vector<size_t> expected_lcp = naive_lcp(text, expected);
+        std::vector<Index> expected_inv(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            expected_inv[expected[i]] = static_cast<Index>(i);
+        }
+        const std::vector<Index> expected_sa(expected.begin(), expected.end());
+        const std::vector<Index> expected_lcp_index(expected_lcp.begin(), expected_lcp.end());
+
+        std::vector<Index> suffix_array;
+        std::vector<Index> inv_suffix_array;
+        get_suffix_array<Index>(std::span<const Char>(text), suffix_array, inv_suffix_array, workspace);
+        check(suffix_array == expected_sa && inv_suffix_array == expected_inv, "get_suffix_array", iteration);
+
+        std::vector<Index> doubling_suffix_array;
+        std::vector<Index> doubling_inv_suffix_array;
+        get_suffix_array_prefix_doubling<Index>(std::span<const Char>(text), doubling_suffix_array, doubling_inv_suffix_array, workspace);
+        check(doubling_suffix_array == expected_sa && doubling_inv_suffix_array == expected_inv, "get_suffix_array_prefix_doubling", iteration);
+
+        check(calculate_lcp<Index>(std::span<const Char>(text), expected_sa, expected_inv) == expected_lcp_index, "calculate_lcp", iteration);
+        std::vector<Index> lcp;
+        std::vector<Index> plcp;
+        calculate_lcp<Index>(std::span<const Char>(text), expected_sa, lcp, plcp);
+        check(lcp == expected_lcp_index, "calculate_lcp phi", iteration);
+    }
+
+    void check_lcs(const std::vector<uint8_t>& first, const std::vector<uint8_t>& second, Workspace& workspace, size_t iteration) {
+        const size_t expected = brute_force_lcs_len(first, second);
+        check(get_longest_cmn_substr_len(first, second, workspace) == expected, "get_longest_cmn_substr_len", iteration);
+        const SuffixAutomaton automaton(second);
+        check(automaton.longest_cmn_substr_len(first) == expected, "SuffixAutomaton::longest_cmn_substr_len", iteration);
+    }
+
+    // Суффиксный массив на потоках строится другим алгоритмом,
+    //   только для строк от 64 Кб: сверяем с построением в одном
+    //   потоке при разном числе потоков, в том числе большем, чем
+    //   ядер.
+    template<typename Char>
+    void check_parallel_suffix_array(const std::vector<Char>& text, Workspace& workspace, size_t iteration) {
+        std::vector<uint32_t> expected_sa;
+        std::vector<uint32_t> expected_inv;
+        get_suffix_array<uint32_t>(std::span<const Char>(text), expected_sa, expected_inv, workspace);
+        for (size_t num_threads: {2, 7}) {
+            std::vector<uint32_t> suffix_array;
+            std::vector<uint32_t> inv_suffix_array;
+            get_suffix_array<uint32_t>(std::span<const Char>(text), suffix_array, inv_suffix_array, workspace, num_threads);
+            check(suffix_array == expected_sa && inv_suffix_array == expected_inv, "get_suffix_array on threads", iteration);
+        }
+    }
+
+    // Отрезки со сдвигом от начала буфера, чтобы блоки были и
+    //   невыровненными. Отличие в случайном месте или его нет.
+    void check_byte_compare(std::mt19937_64& rng, size_t iteration) {
+        const size_t size = rng() % 100;
+        const size_t first_offset = rng() % 32;
+        const size_t second_offset = rng() % 32;
+        std::vector<uint8_t> first(first_offset + size + 1);
+        std::vector<uint8_t> second(second_offset + size + 1);
+        for (uint8_t& chr: first) {
+            chr = static_cast<uint8_t>(rng());
+        }
+        std::copy_n(first.begin() + static_cast<std::ptrdiff_t>(first_offset), size + 1, second.begin() + static_cast<std::ptrdiff_t>(second_offset));
+        if (rng() % 4 != 0) {
+            second[second_offset + rng() % (size + 1)] ^= static_cast<uint8_t>(1 + rng() % 255);
+        }
+        const uint8_t* first_begin = first.data() + first_offset;
+        const uint8_t* second_begin = second.data() + second_offset;
+        const size_t limit = rng() % (size + 2);
+
+        size_t expected_prefix = 0;
+        while (expected_prefix < limit && first_begin[expected_prefix] == second_begin[expected_prefix]) {
+            ++expected_prefix;
+        }
+        check(common_prefix_len(first_begin, second_begin, limit) == expected_prefix, "common_prefix_len", iteration);
+
+        size_t expected_suffix = 0;
+        while (expected_suffix < limit && first_begin[size - expected_suffix] == second_begin[size - expected_suffix]) {
+            ++expected_suffix;
+        }
+        check(common_suffix_len(first_begin + size + 1, second_begin + size + 1, limit) == expected_suffix, "common_suffix_len", iteration);
+
+        // 16-битные символы поверх тех же байт, с чётным сдвигом.
+        const size_t wide_limit = limit / 2;
+        const auto* first_wide = reinterpret_cast<const uint16_t*>(first.data() + (first_offset & ~static_cast<size_t>(1)));
+        const auto* second_wide = reinterpret_cast<const uint16_t*>(second.data() + (second_offset & ~static_cast<size_t>(1)));
+        size_t expected_wide = 0;
+        while (expected_wide < wide_limit && first_wide[expected_wide] == second_wide[expected_wide]) {
+            ++expected_wide;
+        }
+        check(common_prefix_len(first_wide, second_wide, wide_limit) == expected_wide, "common_prefix_len uint16_t", iteration);
+    }
+}
+
+int main() {
+    std::mt19937_64 rng(1);
+    Workspace workspace;
+    for (size_t iteration = 0; iteration < 3000; ++iteration) {
+        const size_t alphabet_size = iteration % 2 == 0 ? 1 + rng() % 4 : 1 + rng() % 256;
+        const size_t size = 1 + rng() % 300;
+
+        const std::vector<uint8_t> text = make_string<uint8_t>(size, alphabet_size, rng);
+        check_suffix_array<uint32_t>(text, workspace, iteration);
+        check_suffix_array<size_t>(text, workspace, iteration);
+        // Символы больше 255, как у разделителей.
+        const std::vector<uint16_t> wide_text = make_string<uint16_t>(size, alphabet_size + 300, rng);
+        check_suffix_array<uint32_t>(wide_text, workspace, iteration);
+
+        // Вторая строка иногда продолжает первую, чтобы общие
+        //   подстроки были длинными.
+        std::vector<uint8_t> second = make_string<uint8_t>(rng() % 600, alphabet_size, rng);
+        if (iteration % 3 == 0) {
+            second.insert(second.begin() + static_cast<std::ptrdiff_t>(rng() % (second.size() + 1)), text.begin() + static_cast<std::ptrdiff_t>(rng() % text.size()), text.end());
+        }
+        check_lcs(text, second, workspace, iteration);
+    }
+    for (size_t iteration = 0; iteration < 30000; ++iteration) {
+        check_byte_compare(rng, iteration);
+    }
+    for (size_t iteration = 0; iteration < 4; ++iteration) {
+        const size_t alphabet_size = iteration % 2 == 0 ? 1 + rng() % 4 : 256;
+        const size_t size = (1 << 16) + rng() % 4096;
+        check_parallel_suffix_array(make_string<uint8_t>(size, alphabet_size, rng), workspace, iteration);
+        check_parallel_suffix_array(make_string<uint16_t>(size, alphabet_size + 300, rng), workspace, iteration);
+
+        const std::vector<uint8_t> first = make_string<uint8_t>(size / 2, alphabet_size, rng);
+        std::vector<uint8_t> second = make_string<uint8_t>(size / 2, alphabet_size, rng);
+        second.insert(second.end(), first.begin(), first.begin() + static_cast<std::ptrdiff_t>(rng() % first.size()));
+        const size_t expected = get_longest_cmn_substr_len(first, second, workspace);
+        for (size_t num_threads: {2, 5}) {
+            check(get_longest_cmn_substr_len(first, second, workspace, num_threads) == expected, "get_longest_cmn_substr_len on threads", iteration);
+        }
+    }
+
+    if (num_failures != 0) {
+        std::cerr << num_failures << " checks failed\n";
+        return 1;
+    }
+    return 0;
+}
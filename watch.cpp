@@ -0,0 +1,113 @@
+#include "watch.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+    constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE;
+    // Сколько ждать следующего события, прежде чем считать
+    //   пачку изменений законченной.
+    constexpr int kSettleTimeMs = 100;
+    // Буфер на много событий: их длина зависит от длины имени.
+    constexpr size_t kEventBufferSize = 64 * 1024;
+}
+
+DirectoryWatcher::DirectoryWatcher(std::span<const fs::path> dirs) {
+    fd_ = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd_ < 0) {
+        throw std::system_error(errno, std::generic_category(), "inotify_init1");
+    }
+    // Одна директория может быть передана несколько раз, в том
+    //   числе под разными путями. Дескриптор у неё один, и его
+    //   события относятся ко всем её номерам.
+    std::vector<fs::path> canonical_dirs;
+    for (const fs::path& dir: dirs) {
+        std::error_code canonical_error;
+        fs::path canonical_dir = fs::canonical(dir, canonical_error);
+        if (canonical_error) {
+            // Об ошибке сообщит inotify_add_watch.
+            canonical_dir = dir;
+        }
+        auto same = std::find(canonical_dirs.begin(), canonical_dirs.end(), canonical_dir);
+        int watch = -1;
+        if (same != canonical_dirs.end()) {
+            watch = watches_[static_cast<size_t>(same - canonical_dirs.begin())];
+        } else {
+            watch = ::inotify_add_watch(fd_, dir.c_str(), kWatchMask);
+            if (watch < 0) {
+                int error = errno;
+                ::close(fd_);
+                throw std::system_error(error, std::generic_category(), dir.string());
+            }
+        }
+        canonical_dirs.push_back(std::move(canonical_dir));
+        watches_.push_back(watch);
+    }
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    ::close(fd_);
+}
+
+bool DirectoryWatcher::read_events(WatchEvents& events) {
+    alignas(inotify_event) char buffer[kEventBufferSize];
+    bool has_events = false;
+    for (;;) {
+        ssize_t size = ::read(fd_, buffer, sizeof(buffer));
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                return has_events;
+            }
+            throw std::system_error(errno, std::generic_category(), "read inotify");
+        }
+        for (ssize_t pos = 0; pos < size;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + pos);
+            pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            has_events = true;
+            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                events.overflowed = true;
+                continue;
+            }
+            if (event->len == 0 || (event->mask & IN_ISDIR) != 0) {
+                continue;
+            }
+            // Дескриптор общий у всех номеров одной директории.
+            for (size_t dir = 0; dir < watches_.size(); ++dir) {
+                if (watches_[dir] == event->wd) {
+                    events.changes.push_back(FileChange{dir, std::string(event->name)});
+                }
+            }
+        }
+    }
+}
+
+WatchEvents DirectoryWatcher::wait() {
+    WatchEvents events;
+    int timeout = -1;
+    for (;;) {
+        pollfd request{fd_, POLLIN, 0};
+        int ready = ::poll(&request, 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "poll inotify");
+        }
+        if (ready == 0) {
+            // Пауза после пачки событий.
+            return events;
+        }
+        if (read_events(events)) {
+            timeout = kSettleTimeMs;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "corpus.hpp"
+
+// Файл, который появился, изменился или пропал. dir -- номер
+//   директории в списке, переданном DirectoryWatcher.
+struct FileChange {
+    size_t dir = 0;
+    std::string name;
+};
+
+struct WatchEvents {
+    std::vector<FileChange> changes;
+    // Очередь событий ядра переполнилась, часть изменений
+    //   потеряна: директории нужно просмотреть заново целиком.
+    bool overflowed = false;
+};
+
+// Наблюдение за директориями через inotify. Файл считается
+//   изменённым, когда его закрыли после записи или переместили
+//   в директорию; пропавшим -- когда удалили или переместили
+//   из неё. Открытие на запись само по себе не событие, чтобы
+//   не читать недописанный файл.
+class DirectoryWatcher {
+public:
+    // Бросает std::system_error, если наблюдение не началось.
+    explicit DirectoryWatcher(std::span<const fs::path> dirs);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Ждёт изменений. События, пришедшие друг за другом без
+    //   паузы, собираются в один ответ: копирование нескольких
+    //   файлов даёт один пересчёт, а не по пересчёту на файл.
+    //   Одно имя может встретиться несколько раз.
+    WatchEvents wait();
+
+private:
+    // Дочитывает доступные события, false -- событий не было.
+    bool read_events(WatchEvents& events);
+
+    int fd_ = -1;
+    // watches_[dir] -- дескриптор наблюдения за директорией dir.
+    //   У одной директории под разными номерами он один и тот же.
+    std::vector<int> watches_;
+};
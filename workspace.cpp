@@ -0,0 +1,49 @@
+#include "workspace.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace {
+    // Выравнивание блоков из кучи с запасом для любых типов.
+    constexpr size_t kBlockAlignment = alignof(std::max_align_t);
+}
+
+void Workspace::reserve(size_t bytes) {
+    assert(used_ == 0 && overflow_.empty());
+    if (bytes <= capacity_) {
+        return;
+    }
+    block_ = std::make_unique_for_overwrite<std::byte[]>(bytes);
+    capacity_ = bytes;
+}
+
+void* Workspace::allocate_bytes(size_t bytes, size_t alignment) {
+    assert(alignment <= kBlockAlignment);
+    const size_t offset = (used_ + alignment - 1) / alignment * alignment;
+    if (offset + bytes <= capacity_) {
+        used_ = offset + bytes;
+        peak_ = std::max(peak_, used_ + overflow_bytes_);
+        return block_.get() + offset;
+    }
+
+    // Блока не хватило. Выделяем отдельно, блок увеличится, когда
+    //   всё будет возвращено.
+    const size_t block_bytes = bytes + kBlockAlignment;
+    overflow_.emplace_back(std::make_unique_for_overwrite<std::byte[]>(std::max<size_t>(bytes, 1)), block_bytes);
+    overflow_bytes_ += block_bytes;
+    peak_ = std::max(peak_, used_ + overflow_bytes_);
+    return overflow_.back().first.get();
+}
+
+void Workspace::release(Mark mark) {
+    assert(mark.used <= used_ && mark.num_overflow <= overflow_.size());
+    used_ = mark.used;
+    while (overflow_.size() > mark.num_overflow) {
+        overflow_bytes_ -= overflow_.back().second;
+        overflow_.pop_back();
+    }
+    if (used_ == 0 && overflow_.empty() && peak_ > capacity_) {
+        reserve(peak_);
+    }
+}
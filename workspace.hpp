@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Рабочая память для временных массивов алгоритмов: суффиксного
+//   массива, рангов, lcp, хеш-таблиц. Один объект на поток,
+//   переиспользуется между сравнениями пар.
+// Память выдаётся из одного большого блока сдвигом указателя и
+//   возвращается стеком: mark() запоминает положение, release()
+//   откатывает к нему. Если блока не хватило, недостающее берётся
+//   из кучи отдельными блоками, а когда всё возвращено, блок
+//   увеличивается до наибольшего использованного объёма. Потому
+//   после первого сравнения самой большой пары выделений из кучи
+//   нет совсем.
+class Workspace {
+public:
+    Workspace() = default;
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+    Workspace(Workspace&&) = default;
+    Workspace& operator=(Workspace&&) = default;
+
+    // Заранее выделяет блок, чтобы выделения общим объёмом до
+    //   bytes обошлись без кучи. Только когда всё возвращено.
+    void reserve(size_t bytes);
+
+    // Память не инициализируется.
+    template<typename T>
+    std::span<T> allocate(size_t count) {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+        return std::span<T>(static_cast<T*>(allocate_bytes(count * sizeof(T), alignof(T))), count);
+    }
+
+    // Положение в блоке и число выделенных из кучи блоков.
+    struct Mark {
+        size_t used = 0;
+        size_t num_overflow = 0;
+    };
+
+    Mark mark() const {
+        return Mark{used_, overflow_.size()};
+    }
+
+    void release(Mark mark);
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    void* allocate_bytes(size_t bytes, size_t alignment);
+
+    std::unique_ptr<std::byte[]> block_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    // Наибольший объём, который был нужен одновременно.
+    size_t peak_ = 0;
+    // Блоки из кучи и их размеры, в порядке выделения.
+    std::vector<std::pair<std::unique_ptr<std::byte[]>, size_t>> overflow_;
+    size_t overflow_bytes_ = 0;
+};
+
+// Возвращает всю память, выделенную за время жизни объекта.
+class WorkspaceScope {
+public:
+    explicit WorkspaceScope(Workspace& workspace): workspace_(workspace), mark_(workspace.mark()) {
+    }
+
+    WorkspaceScope(const WorkspaceScope&) = delete;
+    WorkspaceScope& operator=(const WorkspaceScope&) = delete;
+
+    ~WorkspaceScope() {
+        workspace_.release(mark_);
+    }
+
+private:
+    Workspace& workspace_;
+    Workspace::Mark mark_;
+};